@@ -26,32 +26,68 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 
 SOURCES += \
+    busscheduler.cpp \
+    changefilter.cpp \
     communication.cpp \
+    configsnapshot.cpp \
     configuredialog.cpp \
     datasummary.cpp \
+    devicediscovery.cpp \
+    diagnosticsdialog.cpp \
+    e5ccregisters.cpp \
+    e5ccsimulator.cpp \
+    framecapture.cpp \
     gui.cpp \
     helpdialog.cpp \
     joinlinedialog.cpp \
         main.cpp \
         mainwindow.cpp \
+    modbusblock.cpp \
+    modbusgateway.cpp \
+    modbusqueue.cpp \
+    modbusstats.cpp \
+    modbustransport.cpp \
     notify.cpp \
     plotdialog.cpp \
+    pollschedule.cpp \
+    portwatcher.cpp \
     qcustomplot.cpp \
+    rttestimator.cpp \
     safety.cpp \
-    tempdropdialog.cpp
+    serialprobe.cpp \
+    tempdropdialog.cpp \
+    writecoalescer.cpp
 
 HEADERS += \
+    busscheduler.h \
+    changefilter.h \
     communication.h \
+    configsnapshot.h \
     configuredialog.h \
     datasummary.h \
+    devicediscovery.h \
+    diagnosticsdialog.h \
+    e5ccregisters.h \
+    e5ccsimulator.h \
+    framecapture.h \
     helpdialog.h \
     joinlinedialog.h \
         mainwindow.h \
+    modbusblock.h \
+    modbusgateway.h \
+    modbusqueue.h \
+    modbusstats.h \
+    modbustransport.h \
     notify.h \
     plotdialog.h \
+    pollschedule.h \
+    portwatcher.h \
     qcustomplot.h \
+    rttestimator.h \
     safety.h \
-    tempdropdialog.h
+    serialprobe.h \
+    tempdropdialog.h \
+    writecoalescer.h
 
 FORMS += \
         mainwindow.ui
@@ -0,0 +1,115 @@
+#include "busscheduler.h"
+
+void BusScheduler::addDevice(int id, int priority, int interval){
+  const int index = indexOf(id);
+  if (index >= 0) {
+    devices_[index].priority = qMax(1, priority);
+    devices_[index].interval = qMax(0, interval);
+    return;
+  }
+  Device device;
+  device.id = id;
+  device.priority = qMax(1, priority);
+  device.interval = qMax(0, interval);
+  device.pass = virtualTime_;
+  devices_.append(device);
+}
+
+void BusScheduler::removeDevice(int id){
+  const int index = indexOf(id);
+  if (index >= 0) devices_.removeAt(index);
+}
+
+void BusScheduler::clear(){
+  devices_.clear();
+  virtualTime_ = 0;
+}
+
+void BusScheduler::setPriority(int id, int priority){
+  const int index = indexOf(id);
+  if (index >= 0) devices_[index].priority = qMax(1, priority);
+}
+
+/**
+ * @details The due time of the device is moved so that the new interval applies from the last poll on.
+ */
+void BusScheduler::setInterval(int id, int interval){
+  const int index = indexOf(id);
+  if (index < 0) return;
+  Device &device = devices_[index];
+  device.due += qMax(0, interval) - device.interval;
+  device.interval = qMax(0, interval);
+}
+
+void BusScheduler::setIntervalAll(int interval){
+  for (const Device &device : qAsConst(devices_)) setInterval(device.id, interval);
+}
+
+void BusScheduler::trigger(int id, qint64 now){
+  const int index = indexOf(id);
+  if (index >= 0) devices_[index].due = qMin(devices_[index].due, now);
+}
+
+/**
+ * @details Among the due devices the one with the smallest pass wins. A device that was idle for a
+ * while does not keep an old pass, otherwise it could monopolize the line to catch up.
+ */
+int BusScheduler::next(qint64 now){
+  int best = -1;
+  quint64 bestPass = 0;
+  for (int i = 0; i < devices_.size(); i++) {
+    const Device &device = devices_.at(i);
+    if (device.due > now) continue;
+    const quint64 pass = qMax(device.pass, virtualTime_);
+    if (best < 0 || pass < bestPass) {
+      best = i;
+      bestPass = pass;
+    }
+  }
+  if (best < 0) return -1;
+  Device &device = devices_[best];
+  virtualTime_ = bestPass;
+  device.pass = bestPass + stride(device);
+  device.due = now + device.interval;
+  device.polls++;
+  return device.id;
+}
+
+qint64 BusScheduler::nextDue() const {
+  qint64 due = -1;
+  for (const Device &device : devices_) {
+    if (due < 0 || device.due < due) due = device.due;
+  }
+  return due;
+}
+
+double BusScheduler::share(int id) const {
+  quint64 total = 0;
+  for (const Device &device : devices_) total += device.polls;
+  const int index = indexOf(id);
+  if (index < 0 || total == 0) return 0.0;
+  return static_cast<double>(devices_.at(index).polls) / total;
+}
+
+bool BusScheduler::contains(int id) const {return indexOf(id) >= 0;}
+int BusScheduler::count() const {return devices_.size();}
+
+QList<int> BusScheduler::deviceIds() const {
+  QList<int> ids;
+  for (const Device &device : devices_) ids.append(device.id);
+  return ids;
+}
+
+const BusScheduler::Device* BusScheduler::device(int id) const {
+  const int index = indexOf(id);
+  return index < 0 ? nullptr : &devices_.at(index);
+}
+
+int BusScheduler::indexOf(int id) const {
+  for (int i = 0; i < devices_.size(); i++) {
+    if (devices_.at(i).id == id) return i;
+  }
+  return -1;
+}
+
+quint64 BusScheduler::stride(const Device &device) const {return strideBase / device.priority;}
@@ -0,0 +1,110 @@
+/**
+ * @file busscheduler.h
+ * @brief Declaration of the BusScheduler class, which shares one Modbus line between several E5CC units.
+ */
+
+#ifndef BUSSCHEDULER_H
+#define BUSSCHEDULER_H
+
+#include <QList>
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @brief The BusScheduler class decides which device on a shared RS-485 line is polled next.
+ *
+ * Every device has its own poll interval and priority. A device becomes due when its interval
+ * has elapsed. When several devices are due at the same time, the scheduler uses stride
+ * scheduling: each device advances its pass by a stride inversely proportional to its priority
+ * and the due device with the smallest pass is served first. Devices of equal priority are
+ * therefore polled round-robin, and on a saturated line each device gets a share of the polls
+ * proportional to its priority.
+ */
+class BusScheduler
+{
+public:
+  /**
+   * @brief The Device struct holds the scheduling state of one slave.
+   */
+  struct Device {
+    int id{}; /**< Modbus slave address of the device */
+    int priority{1}; /**< Relative share of the bus, at least 1 */
+    int interval{3000}; /**< Time in milliseconds between two polls */
+    qint64 due{0}; /**< Time in milliseconds at which the next poll is due */
+    quint64 pass{0}; /**< Virtual time of the stride scheduler */
+    quint64 polls{0}; /**< Number of polls granted to the device */
+  };
+
+  /**
+   * @brief Adds a device or updates its priority and interval if it is already known.
+   * @param id The Modbus slave address.
+   * @param priority The relative share of the bus.
+   * @param interval The time in milliseconds between two polls.
+   */
+  void addDevice(int id, int priority = 1, int interval = 3000);
+
+  /**
+   * @brief Removes a device from the schedule.
+   * @param id The Modbus slave address.
+   */
+  void removeDevice(int id);
+
+  /**
+   * @brief Removes all devices.
+   */
+  void clear();
+
+  bool contains(int id) const;
+  QList<int> deviceIds() const;
+  const Device* device(int id) const;
+  int count() const;
+
+  void setPriority(int id, int priority);
+  void setInterval(int id, int interval);
+
+  /**
+   * @brief Sets the poll interval of all devices.
+   * @param interval The time in milliseconds between two polls.
+   */
+  void setIntervalAll(int interval);
+
+  /**
+   * @brief Makes a device due at the given time, e.g. to poll it as soon as possible.
+   * @param id The Modbus slave address.
+   * @param now The current time in milliseconds.
+   */
+  void trigger(int id, qint64 now);
+
+  /**
+   * @brief Picks the device to poll next and books the poll.
+   * @param now The current time in milliseconds.
+   * @return The slave address of the device, or -1 if no device is due.
+   */
+  int next(qint64 now);
+
+  /**
+   * @brief Returns the earliest time at which a device becomes due.
+   * @return The time in milliseconds, or -1 if no device is scheduled.
+   */
+  qint64 nextDue() const;
+
+  /**
+   * @brief Returns the fraction of all granted polls that went to a device.
+   * @param id The Modbus slave address.
+   * @return The share between 0 and 1.
+   */
+  double share(int id) const;
+
+private:
+  enum {
+    strideBase = 1 << 16 /**< Stride of a device with priority 1 */
+  };
+
+  QVector<Device> devices_; /**< The scheduled devices in the order they were added */
+  quint64 virtualTime_{0}; /**< Pass of the device served last */
+
+  int indexOf(int id) const;
+  quint64 stride(const Device &device) const;
+};
+
+#endif // BUSSCHEDULER_H
@@ -0,0 +1,28 @@
+#include "changefilter.h"
+
+ChangeFilter::ChangeFilter(double absolute, double relative, int heartbeat)
+{
+  setDeadband(absolute, relative);
+  setHeartbeat(heartbeat);
+}
+
+bool ChangeFilter::accept(int id, double value, qint64 now){
+  auto it = states_.find(id);
+  if (it != states_.end()) {
+    const double band = qMax(absolute_, relative_ * qAbs(it->value));
+    const bool changed = (band > 0.0) ? qAbs(value - it->value) > band : value != it->value;
+    const bool silent = heartbeat_ > 0 && now - it->published >= heartbeat_;
+    if (!changed && !silent) return false;
+  }
+  State &state = states_[id];
+  state.value = value;
+  state.published = now;
+  return true;
+}
+
+void ChangeFilter::reset(){states_.clear();}
+void ChangeFilter::setDeadband(double absolute, double relative){absolute_ = qMax(0.0, absolute); relative_ = qMax(0.0, relative);}
+void ChangeFilter::setHeartbeat(int heartbeat){heartbeat_ = qMax(0, heartbeat);}
+double ChangeFilter::absolute() const {return absolute_;}
+double ChangeFilter::relative() const {return relative_;}
+int ChangeFilter::heartbeat() const {return heartbeat_;}
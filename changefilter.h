@@ -0,0 +1,73 @@
+/**
+ * @file changefilter.h
+ * @brief Declaration of the ChangeFilter class, which suppresses repeated values of a polled channel.
+ */
+
+#ifndef CHANGEFILTER_H
+#define CHANGEFILTER_H
+
+#include <QHash>
+#include <QtGlobal>
+
+/**
+ * @brief The ChangeFilter class decides whether a polled value is worth publishing.
+ *
+ * A value passes the filter when it differs from the last published value of the same device by
+ * more than the deadband, or when nothing has been published for the heartbeat interval. The
+ * deadband is the larger of an absolute band and a band relative to the last published value.
+ * With both bands at 0 every change passes and only exact repetitions are dropped.
+ */
+class ChangeFilter
+{
+public:
+  /**
+   * @brief The timing enumeration defines the default heartbeat.
+   */
+  enum timing {
+    heartbeatDefault = 30000 /**< Longest silence in ms before an unchanged value is published again */
+  };
+
+  /**
+   * @brief Constructs a filter.
+   * @param absolute The absolute deadband in engineering units.
+   * @param relative The deadband as a fraction of the last published value, e.g. 0.01 for 1 %.
+   * @param heartbeat The longest silence in ms, 0 to publish unchanged values never again.
+   */
+  explicit ChangeFilter(double absolute = 0.0, double relative = 0.0, int heartbeat = heartbeatDefault);
+
+  /**
+   * @brief Checks a new value and remembers it if it passes.
+   * @param id The Modbus slave address of the device the value belongs to.
+   * @param value The new value.
+   * @param now The current time in ms of a monotonic clock.
+   * @return true if the value is to be published.
+   */
+  bool accept(int id, double value, qint64 now);
+
+  /**
+   * @brief Forgets the published values, so the next value of every device passes.
+   */
+  void reset();
+
+  void setDeadband(double absolute, double relative);
+  void setHeartbeat(int heartbeat);
+  double absolute() const;
+  double relative() const;
+  int heartbeat() const;
+
+private:
+  /**
+   * @brief The State struct holds the last published value of one device.
+   */
+  struct State {
+    double value{}; /**< Last published value */
+    qint64 published{}; /**< Time in ms at which the value was published */
+  };
+
+  QHash<int, State> states_; /**< Published values per device */
+  double absolute_{0.0}; /**< Absolute deadband */
+  double relative_{0.0}; /**< Relative deadband */
+  int heartbeat_{heartbeatDefault}; /**< Longest silence in ms, 0 for none */
+};
+
+#endif // CHANGEFILTER_H
@@ -1,390 +1,1151 @@
+#include <algorithm>
 #include <QSerialPortInfo>
-#include <QModbusRtuSerialMaster>
 #include <QException>
 #include <QDebug>
+#include <QSettings>
 #include <QTimer>
-#include <QEventLoop>
+#include <QThread>
+#include <QSharedPointer>
 #include "communication.h"
 
+static_assert(E5ccRegisters::find(static_cast<quint16>(Communication::E5CC_Address::Type::PV)), "PV is missing in the register table");
+static_assert(E5ccRegisters::find(static_cast<quint16>(Communication::E5CC_Address::Type::MV)), "MV is missing in the register table");
+static_assert(E5ccRegisters::find(static_cast<quint16>(Communication::E5CC_Address::Type::SV)), "SV is missing in the register table");
+static_assert(E5ccRegisters::find(static_cast<quint16>(Communication::E5CC_Address::Type::MVupper)), "MVupper is missing in the register table");
+static_assert(E5ccRegisters::find(static_cast<quint16>(Communication::E5CC_Address::Type::MVlower)), "MVlower is missing in the register table");
+static_assert(E5ccRegisters::find(static_cast<quint16>(Communication::E5CC_Address::Type::PID_P)), "PID_P is missing in the register table");
+static_assert(E5ccRegisters::find(static_cast<quint16>(Communication::E5CC_Address::Type::PID_I)), "PID_I is missing in the register table");
+static_assert(E5ccRegisters::find(static_cast<quint16>(Communication::E5CC_Address::Type::PID_D)), "PID_D is missing in the register table");
 
+namespace {
+const double rampSlope = 2.0; /**< |dT/dt| in K/min at which the status is polled fastest */
+const double steadySlope = 0.2; /**< |dT/dt| in K/min below which the process counts as steady */
+const double limitBand = 20.0; /**< Distance in K below the safety limit in which polling speeds up */
+const double mvMargin = 0.1; /**< Distance in % below MVupper at which the output counts as saturated */
+const double slopeWeight = 0.3; /**< Weight of the newest sample in the smoothed slope */
+const int broadcastAddress = 0; /**< Slave address every controller on the line listens to */
+const int readBackChecks = 3; /**< Read-backs of a group write before it counts as failed */
+const int readBackDelay = 200; /**< Time in ms between two direct read-backs */
+const char *const pollGroup = "poll"; /**< QSettings group of the poll settings */
+const char *const registerPolls = "poll/registers"; /**< QSettings array of the register poll rules */
+const double noiseDigits = 1.5; /**< Default deadband of sampleUpdated() in digits, so a change of one digit is noise */
+const char *const filterGroups[] = {"filter", "sample"}; /**< QSettings groups of the signal and the sample change filters */
+const char *const channelNames[] = {"temperature", "mv", "sv", "heaterCurrent"}; /**< QSettings groups of the channels, indexed by Channel */
+
+quint32 readBackKey(int omronID, quint16 address){
+  return (static_cast<quint32>(omronID & 0xFFFF) << 16) | address;
+}
+}
+
+
+/**
+ * @details The object is created without a QObject parent so that it can be moved onto its own
+ * bus thread. Status bar messages are published through the statusMessage() signal, which is
+ * delivered to the status bar of the GUI thread as a queued call.
+ */
 Communication::Communication(QMainWindow *parent, QStatusBar *statusBar)
-  : QObject(parent),
+  : QObject(nullptr),
     statusBar_(statusBar)
 {
-  mutex_.lock();
   mainwindow_ = qobject_cast<MainWindow*>(parent);
+  if (statusBar_) connect(this, &Communication::statusMessage, statusBar_, &QStatusBar::showMessage);
   const auto infos = QSerialPortInfo::availablePorts();
   infos_ = infos;
-  omron_= new QModbusRtuSerialMaster(this);
+  transport_ = new ModbusTransport(this);
+  queue_ = new ModbusQueue(this);
+  queue_->setTransport(transport_);
+  queue_->setStats(&stats_);
+  queue_->setCapture(&capture_);
+  writer_ = new WriteCoalescer(queue_, this);
+  connect(writer_, &WriteCoalescer::failed, this, [this](int serverAddress, quint16 address, qint32, const QString &message) {
+    emit statusMessage(tr("Write response error: %1 (address: 0x%2)").arg(message).arg(address, 4, 16, QChar('0')), 0);
+    const Verification verification = verifications_.take(readBackKey(serverAddress, address));
+    if (verification.done) verification.done(false, 0.0, message);
+  });
+  connect(writer_, &WriteCoalescer::readBack, this, &Communication::finishVerifications);
+  connect(writer_, &WriteCoalescer::superseded, this, [this](int serverAddress, quint16 address, qint32 raw) {
+    const Verification verification = verifications_.take(readBackKey(serverAddress, address));
+    if (!verification.done) return;
+    const E5ccRegister &reg = E5ccRegisters::at(address);
+    verification.done(false, reg.decode(static_cast<quint32>(verification.raw), tempDecimal_),
+                      tr("superseded by %1").arg(reg.decode(static_cast<quint32>(raw), tempDecimal_)));
+  });
+  connect(this, &Communication::groupWriteVerified, this, [this](int omronID, quint16 address, bool ok) {
+    if (address != E5ccRegisters::SV || !groupSV_.contains(omronID)) return;
+    const double SV = groupSV_.take(omronID);
+    if (!ok) {
+      emit statusMessage(tr("SV %1 was not applied: %2").arg(SV).arg(tr("group write not read back")), 0);
+      return;
+    }
+    setSV(SV);
+    emit SVSendFinish(SV);
+  });
+  connect(writer_, &WriteCoalescer::readWriteMultipleRefused, this, [this](int serverAddress) {
+    emit logMsg(tr("Device %1 does not support ReadWriteMultipleRegisters, writing and reading separately").arg(serverAddress));
+  });
+  probe_ = new SerialProbe(this);
+  connect(probe_, &SerialProbe::found, this, [this](const ModbusTransport::Settings &settings) {
+    setSerialSettings(settings.baudRate, settings.parity, settings.stopBits);
+    emit logMsg(tr("Device %1 answers at %2").arg(getOmronID()).arg(SerialProbe::describe(settings)));
+    emit serialSettingsDetected(settings.portName, getOmronID(), settings.baudRate, settings.parity, settings.stopBits);
+    open(settings);
+  });
+  connect(probe_, &SerialProbe::failed, this, [this]() {
+    emit logMsg(tr("Device %1 does not answer at any serial setting").arg(getOmronID()));
+    emit failedConnect();
+  });
+  snapshot_ = new ConfigSnapshot(queue_, this);
+  snapshot_->setTempDecimal(tempDecimal_);
+  setSampleFilter(Channel::Temperature, noiseDigits * E5ccRegisters::at(E5ccRegisters::PV).factor(tempDecimal_), 0.0);
+  setSampleFilter(Channel::MV, noiseDigits * E5ccRegisters::at(E5ccRegisters::MV).factor(tempDecimal_), 0.0);
+  setSampleFilter(Channel::HeaterCurrent, noiseDigits * E5ccRegisters::at(E5ccRegisters::HeaterCurrent).factor(tempDecimal_), 0.0);
+  connect(snapshot_, &ConfigSnapshot::valueChanged, this, &Communication::applySetting);
+  gateway_ = new ModbusGateway(queue_, snapshot_, this);
+  connect(gateway_, &ModbusGateway::written, this, &Communication::applyGatewayWrite);
+  connect(gateway_, &ModbusGateway::clientCountChanged, this, [this](int clients) {
+    emit logMsg(tr("Modbus TCP gateway: %1 client(s) connected").arg(clients));
+  });
+  connect(transport_, &ModbusTransport::reconnecting, this, [this](int attempt) {
+    emit logMsg(tr("Reconnecting to the Modbus device (attempt %1)").arg(attempt));
+  });
+  connect(transport_, &ModbusTransport::disconnected, this, [this]() {
+    if (!transport_->isWanted() || lostAt_ >= 0) return;
+    lostAt_ = busClock_.elapsed();
+    emit logMsg(tr("Connection to the Modbus device lost"));
+  });
+  connect(transport_, &ModbusTransport::connected, this, [this]() {
+    if (lostAt_ >= 0) resynchronize();
+    writer_->resume();
+  });
   timerUpdate_ = new QTimer(this);
-  connectTimer_ = new QTimer(this);
-  connect(connectTimer_, &QTimer::timeout, this, &Communication::checkConnection);
-  connect(timerUpdate_, &QTimer::timeout, this, &Communication::askStatus);
+  timerUpdate_->setSingleShot(true);
+  portWatcher_ = new PortWatcher(this);
+  connect(portWatcher_, &PortWatcher::portRemoved, this, &Communication::serialPortRemoved);
+  connect(portWatcher_, &PortWatcher::portAdded, this, &Communication::serialPortAdded);
+  connect(timerUpdate_, &QTimer::timeout, this, &Communication::pollNext);
+  qRegisterMetaType<DeviceSample>("DeviceSample");
+  busClock_.start();
 }
 
 Communication::~Communication(){
-  mutex_.unlock();
-  delete omron_;
-  delete modbusDevice_;
-  delete modbusReply_;
-}
-
-void Communication::waitForMsec(int msec){
-  QEventLoop eventLoop;
-  QTimer::singleShot(msec, &eventLoop, SLOT(quit()));
-  eventLoop.exec();
-}
-
-void Communication::request(QModbusPdu::FunctionCode code, QByteArray cmd){
-statusBar_->clearMessage();
-modbusReady_ = false;
-QModbusPdu pdu;
-pdu.setFunctionCode(code);
-pdu.setData(cmd);
-QModbusRequest ask(pdu);
-if (auto *reply = omron_->sendRawRequest(ask, omronID_)) {
-    if (!reply->isFinished()) {
-        connect(reply, &QModbusReply::finished, this, [this, reply]() {
-            if (reply->error() == QModbusDevice::ProtocolError) {
-                statusBar_->showMessage(tr("Write response error: %1 (Mobus exception: 0x%2)")
-                    .arg(reply->errorString()).arg(reply->rawResult().exceptionCode(), -1, 16), 0);
-            } else if (reply->error() != QModbusDevice::NoError) {
-                statusBar_->showMessage(tr("Write response error: %1 (code: 0x%2)").
-                    arg(reply->errorString()).arg(reply->error(), -1, 16), 0);
-            }
-            reply->deleteLater();
-            modbusReady_ = true;
-        });
-    } else {
-        // broadcast replies return immediately
-        reply->deleteLater();
-    }
-} else {
-    statusBar_->showMessage(tr("Write error: ") + omron_->errorString(), 0);
-}
+  if (transport_) transport_->disconnectDevice();
 }
 
-void Communication::read(QModbusDataUnit::RegisterType type, quint16 address, int size) {
-QModbusDataUnit ans(type, address, size);
-respondType_ = address;
-modbusReady_ = false;
-if (auto *reply = omron_->sendReadRequest(ans, omronID_)) {
-    if (!reply->isFinished()){
-        connect(reply, &QModbusReply::finished, this, &Communication::readReady);
-    }else{
-        delete reply; // broadcast replies return immediately
-    }
-} else {
-    statusBar_->showMessage(tr("Read error: ") + omron_->errorString(), 0);
-}
+bool Communication::postToBusThread(std::function<void()> task){
+  if (QThread::currentThread() == thread()) return false;
+  QMetaObject::invokeMethod(this, std::move(task), Qt::QueuedConnection);
+  return true;
 }
 
-void Communication::readReady(){
-auto reply = qobject_cast<QModbusReply *>(sender());
-if (!reply) return;
-if (reply->error() == QModbusDevice::ProtocolError) {
-statusBar_->showMessage(tr("Read response error: %1 (Mobus exception: 0x%2)").
-                            arg(reply->errorString()).
-                            arg(reply->rawResult().exceptionCode(), -1, 16), 0);
-} else {
-statusBar_->showMessage(tr("Read response error: %1 (code: 0x%2)").
-                            arg(reply->errorString()).
-                            arg(reply->error(), -1, 16), 0);
-}
-switch (respondType_){
-case static_cast<int>(E5CC_Address::Type::PV): {
-    const QModbusDataUnit unit = reply->result();
-    temperature_ = QString::number(unit.value(1), 10).toDouble() * tempDecimal_;
-    break;
-}
-case static_cast<int>(E5CC_Address::Type::SV):{
-    const QModbusDataUnit unit = reply->result();
-    SV_ = QString::number(unit.value(1), 10).toDouble() * tempDecimal_;
-    break;
+void Communication::request(QModbusPdu::FunctionCode code, QByteArray cmd, ModbusQueue::Handler handler){
+request(QModbusRequest(code, cmd), handler);
 }
-case static_cast<int>(E5CC_Address::Type::MV): {
-    const QModbusDataUnit unit = reply->result();
-    MV_ = QString::number(unit.value(1), 10).toDouble() * tempDecimal_;
-    break;
+
+void Communication::request(const QModbusRequest &ask, ModbusQueue::Handler handler, ModbusQueue::Lane lane){
+if (postToBusThread([=]() {request(ask, handler, lane);})) return;
+emit statusMessage(QString(), 0);
+queue_->enqueue(ask, getOmronID(), [this, handler](const ModbusResult &result) {
+    if (result.error == QModbusDevice::ProtocolError) {
+        emit statusMessage(tr("Write response error: %1 (Mobus exception: 0x%2)")
+            .arg(result.errorString).arg(result.response.exceptionCode(), -1, 16), 0);
+    } else if (result.error != QModbusDevice::NoError) {
+        emit statusMessage(tr("Write response error: %1 (code: 0x%2)").
+            arg(result.errorString).arg(result.error, -1, 16), 0);
+    }
+    if (handler) handler(result);
+}, lane);
 }
-case static_cast<int>(E5CC_Address::Type::MVupper): {
-    const QModbusDataUnit unit = reply->result();
-    MVupper_ = QString::number(unit.value(1), 10).toDouble() * tempDecimal_;
-    break;
+
+void Communication::read(QModbusDataUnit::RegisterType type, quint16 address, int size, ModbusQueue::Handler handler, ModbusQueue::Lane lane) {
+if (postToBusThread([=]() {read(type, address, size, handler, lane);})) return;
+const QModbusPdu::FunctionCode code = (type == QModbusDataUnit::InputRegisters)
+    ? QModbusPdu::ReadInputRegisters : QModbusPdu::ReadHoldingRegisters;
+if (!handler) handler = [this](const ModbusResult &result) {readReady(result);};
+readDevice(getOmronID(), code, address, size, handler, lane);
 }
-case static_cast<int>(E5CC_Address::Type::MVlower): {
-    const QModbusDataUnit unit = reply->result();
-    MVlower_ = QString::number(unit.value(1), 10).toDouble() * tempDecimal_;
-    break;
+
+void Communication::readDevice(int omronID, QModbusPdu::FunctionCode code, quint16 address, int size, ModbusQueue::Handler handler, ModbusQueue::Lane lane){
+QModbusRequest ask(code, address, static_cast<quint16>(size));
+queue_->enqueue(ask, omronID, handler, lane);
 }
-case static_cast<int>(E5CC_Address::Type::PID_P): {
-    const QModbusDataUnit unit = reply->result();
-    pid_P_ = QString::number(unit.value(1), 10).toDouble() * 0.1;
-    break;
+
+bool Communication::checkRead(const ModbusResult &result){
+if (result.error == QModbusDevice::ProtocolError) {
+emit statusMessage(tr("Read response error: %1 (Mobus exception: 0x%2)").
+                            arg(result.errorString).
+                            arg(result.response.exceptionCode(), -1, 16), 0);
+return false;
+} else if (result.error != QModbusDevice::NoError) {
+emit statusMessage(tr("Read response error: %1 (code: 0x%2)").
+                            arg(result.errorString).
+                            arg(result.error, -1, 16), 0);
+return false;
 }
-case static_cast<int>(E5CC_Address::Type::PID_I): {
-    const QModbusDataUnit unit = reply->result();
-    pid_I_ = QString::number(unit.value(1), 10).toDouble();
-    break;
+return true;
 }
-case static_cast<int>(E5CC_Address::Type::PID_D): {
-    const QModbusDataUnit unit = reply->result();
-    pid_D_ = QString::number(unit.value(1), 10).toDouble();
-    break;
+
+bool Communication::readReady(const ModbusResult &result){
+if (!checkRead(result)) return false;
+const quint16 start = result.startAddress();
+const QVector<quint16> values = result.values();
+if (decodeRegisters(start, values)) return true;
+emit logMsg("respond count: " + QString::number(values.size()));
+for (int i = 0; i < values.size(); i++) {
+    const QString entry = tr("Address: %1, Value: %2").arg(start + i).arg(QString::number(values.at(i), 10));
+    emit logMsg(entry);
 }
-default: {
-    const QModbusDataUnit unit = reply->result();
-    emit logMsg("respond count: " + QString::number(unit.valueCount()));
-    for (uint i = 0; i < unit.valueCount(); i++) {
-        const QString entry = tr("Address: %1, Value: %2").arg(unit.startAddress()).arg(QString::number(unit.value(i), 10));
-        emit logMsg(entry);
-    }
-    break;
+return true;
 }
+
+/**
+ * @details Every E5CC_Address::Type covered by the reply is decoded, so a single block read
+ * updates all the variables of its window. Width, signedness and scale come from the
+ * E5ccRegisters table. The decoding relies on the start address of the request the reply
+ * belongs to.
+ */
+bool Communication::decodeRegisters(quint16 start, const QVector<quint16> &values){
+bool decoded = false;
+QMutexLocker locker(&mutex_);
+const struct {quint16 address; double *target;} variables[] = {
+  {E5ccRegisters::PV, &temperature_}, {E5ccRegisters::MV, &MV_}, {E5ccRegisters::SV, &SV_},
+  {E5ccRegisters::MVupper, &MVupper_}, {E5ccRegisters::MVlower, &MVlower_},
+  {E5ccRegisters::PID_P, &pid_P_}, {E5ccRegisters::PID_I, &pid_I_}, {E5ccRegisters::PID_D, &pid_D_}
+};
+for (const auto &variable : variables) {
+  if (E5ccRegisters::at(variable.address).decodeFrom(start, values, *variable.target, tempDecimal_)) decoded = true;
 }
-reply->deleteLater();
-modbusReady_ = true;
+return decoded;
 }
 
-QString Communication::formatHex(int value, int digit){
-  QString valueStr = QString::number(value, 16).toUpper();
-  while(valueStr.size() < digit){
-      valueStr.insert(0, "0");
+void Communication::Connection(){
+  if (postToBusThread([this]() {Connection();})) return;
+  ModbusTransport::Settings settings = ModbusTransport::parse(getPortName());
+  settings.timeout = timing::timeOut;
+  settings.numberOfRetries = 0;
+  settings.baudRate = getBaudRate();
+  settings.parity = getParity();
+  settings.stopBits = getStopBits();
+  if (settings.type == ModbusTransport::Type::Rtu && isAutoProbe()) {
+    transport_->disconnectDevice();
+    emit logMsg(tr("Detecting the serial settings of device %1 on %2...").arg(getOmronID()).arg(settings.portName));
+    probe_->start(SerialProbe::candidates(settings), getOmronID());
+    return;
   }
-  return valueStr;
+  open(settings);
 }
 
-QString Communication::formatE5CCAddress(E5CC_Address::Type address, int width){
-  return formatHex(static_cast<int>(address), width);
-}
-
-void Communication::Connection(){
-  omron_= new QModbusRtuSerialMaster(this);
-  omron_->setConnectionParameter(QModbusDevice::SerialPortNameParameter, portName_);
-  omron_->setConnectionParameter(QModbusDevice::SerialBaudRateParameter, QSerialPort::Baud9600);
-  omron_->setConnectionParameter(QModbusDevice::SerialDataBitsParameter, QSerialPort::Data8);
-  omron_->setConnectionParameter(QModbusDevice::SerialParityParameter, QSerialPort::NoParity);
-  omron_->setConnectionParameter(QModbusDevice::SerialStopBitsParameter, QSerialPort::TwoStop);
-  omron_->setTimeout(timing::timeOut);
-  omron_->setNumberOfRetries(0);
-  serialPort_ = new QSerialPort(portName_, this);
-  if(omron_->connectDevice()){
+void Communication::open(const ModbusTransport::Settings &settings){
+  lostAt_ = -1;
+  transport_->setSettings(settings);
+  queue_->setMaxInFlight(transport_->maxInFlight());
+  queue_->rttEstimator()->setInitial(settings.timeout);
+  queue_->rttEstimator()->reset();
+  if(transport_->connectDevice()){
    emit deviceConnect();
-   QString cmd = "00 00 01 01";
-   QByteArray value = QByteArray::fromHex(cmd.toStdString().c_str());
-   request(QModbusPdu::WriteSingleRegister, value);
+   request(E5ccRegisters::commandRequest(E5ccRegisters::Command::Stop));
+   snapshot_->setRefreshInterval(ConfigSnapshot::refreshDefault);
   }else{
+    snapshot_->setRefreshInterval(0);
+    transport_->disconnectDevice();
     emit failedConnect();
   }
 }
 
+/**
+ * @details With group control the run command goes to every polled controller through
+ * sendGroupCommand(), which broadcasts it if broadcast writes are enabled.
+ */
 void Communication::Run(){
-QString cmd = "00 00 01 00";
-QByteArray value = QByteArray::fromHex(cmd.toStdString().c_str());
-request(QModbusPdu::WriteSingleRegister, value);
-timerUpdate_->start(intervalUpdate_);
-connectTimer_->start(intervalConectionCheck_);
+if (postToBusThread([this]() {Run();})) return;
+mutex_.lock();
+if (!scheduler_.contains(omronID_)) scheduler_.addDevice(omronID_, 1, intervalUpdate_);
+const QList<int> group = groupControl_ ? scheduler_.deviceIds() : QList<int>();
+mutex_.unlock();
+if (group.size() > 1) sendGroupCommand(group, E5ccRegisters::Command::Run);
+else request(E5ccRegisters::commandRequest(E5ccRegisters::Command::Run));
+commandedRun_.insert(getOmronID(), true);
+portWatcher_->start(getIntervalConectionCheck());
+mutex_.lock();
+stateCommanded_.insert(omronID_, busClock_.elapsed());
+lastStatus_.clear();
+scheduler_.trigger(omronID_, busClock_.elapsed());
+runStarted_ = busClock_.elapsed();
+busBusy_ = 0;
+for (ChangeFilter &filter : filters_) filter.reset();
+for (ChangeFilter &filter : sampleFilters_) filter.reset();
+pollSchedule_.reset();
+polling_ = true;
+mutex_.unlock();
+schedulePoll();
 }
 
+/**
+ * @details With group control the command goes to every polled controller through
+ * sendGroupCommand() like run and stop.
+ */
 void Communication::sendRequestAT(int atFlag){
-statusBar_ -> clearMessage();
+emit statusMessage(QString(), 0);
+mutex_.lock();
+const QList<int> group = groupControl_ ? scheduler_.deviceIds() : QList<int>();
+stateCommanded_.insert(omronID_, busClock_.elapsed());
+mutex_.unlock();
+if (group.size() > 1) {
+  switch (atFlag){
+    case 1: sendGroupCommand(group, E5ccRegisters::Command::AT100); break;
+    case 2: sendGroupCommand(group, E5ccRegisters::Command::AT40); break;
+    default: sendGroupCommand(group, E5ccRegisters::Command::ATCancel); break;
+  }
+  emit ATSendFinish(atFlag);
+  return;
+}
 switch (atFlag){
-  case 1:{
-      QString cmd = "00 00 03 01";
-      QByteArray value = QByteArray::fromHex(cmd.toStdString().c_str());
-      request(QModbusPdu::WriteSingleRegister, value);
-      break;
-    }
-  case 2:{
-      QString cmd = "00 00 03 02";
-      QByteArray value = QByteArray::fromHex(cmd.toStdString().c_str());
-      request(QModbusPdu::WriteSingleRegister, value);
-      break;
-   }
-  default:{
-    QString cmd = "00 00 03 00";
-    QByteArray value = QByteArray::fromHex(cmd.toStdString().c_str());
-    request(QModbusPdu::WriteSingleRegister, value);
+  case 1:
+    request(E5ccRegisters::commandRequest(E5ccRegisters::Command::AT100), ModbusQueue::Handler(), ModbusQueue::Lane::Low);
+    break;
+  case 2:
+    request(E5ccRegisters::commandRequest(E5ccRegisters::Command::AT40), ModbusQueue::Handler(), ModbusQueue::Lane::Low);
+    break;
+  default:
+    request(E5ccRegisters::commandRequest(E5ccRegisters::Command::ATCancel), ModbusQueue::Handler(), ModbusQueue::Lane::Low);
     break;
-  }
 }
 emit ATSendFinish(atFlag);
 }
 
+/**
+ * @details The set value is written and read back in one go by writeAndVerify(), so
+ * SVSendFinish() carries the value the controller has taken instead of the value requested.
+ * With group control every polled controller gets the value through sendGroupSV(), and the
+ * read-back of the selected one decides SVSendFinish().
+ */
 void Communication::sendRequestSV(double SV){
-statusBar_->clearMessage();
-changeSVValue(SV);
-emit SVSendFinish(SV);
+if (postToBusThread([=]() {sendRequestSV(SV);})) return;
+emit statusMessage(QString(), 0);
+const QList<int> group = isGroupControl() ? getPollDevices() : QList<int>();
+if (group.size() > 1 && group.contains(getOmronID())) {
+  groupSV_.insert(getOmronID(), SV);
+  sendGroupSV(group, SV);
+  return;
+}
+groupSV_.remove(getOmronID());
+writeAndVerify(getOmronID(), E5ccRegisters::SV, SV, [this, SV](bool ok, double value, const QString &message) {
+  if (!ok) {
+    emit statusMessage(tr("SV %1 was not applied: %2").arg(SV).arg(message), 0);
+    emit logMsg(tr("SV %1 was not applied: %2").arg(SV).arg(message));
+    return;
+  }
+  setSV(value);
+  emit SVSendFinish(value);
+});
 }
 
+/**
+ * @details The write goes through the WriteCoalescer like every other write of the register, so
+ * an older value still pending there cannot overtake it. The coalescer sends it as
+ * ReadWriteMultipleRegisters, so the controller writes the register and returns it in the same
+ * transaction, or as a write followed by a read if the controller refuses that function code.
+ * A newer call for the same register replaces an older one, whose handler is told so.
+ */
+void Communication::writeAndVerify(int omronID, quint16 address, double value, VerifyHandler done){
+const E5ccRegister &reg = E5ccRegisters::at(address);
+const qint32 raw = reg.encode(value, tempDecimal_);
+const quint32 key = readBackKey(omronID, address);
+commanded_.insert(key, raw);
+const Verification previous = verifications_.take(key);
+if (previous.done) previous.done(false, reg.decode(static_cast<quint32>(previous.raw), tempDecimal_), tr("superseded by %1").arg(value));
+verifications_.insert(key, {raw, done});
+writer_->writeVerified(omronID, address, raw);
+}
+
+void Communication::finishVerifications(int omronID, quint16 start, const QVector<quint16> &values){
+snapshot_->update(omronID, start, values);
+struct Finished {VerifyHandler done; bool ok; double value;};
+QVector<Finished> finished;
+for (auto it = verifications_.begin(); it != verifications_.end();) {
+  const E5ccRegister &reg = E5ccRegisters::at(static_cast<quint16>(it.key() & 0xFFFF));
+  double readBack = 0.0;
+  if (static_cast<int>(it.key() >> 16) != omronID || !reg.decodeFrom(start, values, readBack, tempDecimal_)) {
+    ++it;
+    continue;
+  }
+  finished.append({it->done, reg.encode(readBack, tempDecimal_) == it->raw, readBack});
+  it = verifications_.erase(it);
+}
+for (const Finished &entry : qAsConst(finished)) {
+  entry.done(entry.ok, entry.value, entry.ok ? QString() : tr("read back %1").arg(entry.value));
+}
+}
+
+/**
+ * @details With group control every polled controller is stopped through sendGroupCommand().
+ * The poll ends first, so the group read-backs are sent as direct reads.
+ */
 void Communication::Stop(){
-QString cmd = "00 00 01 01";
-QByteArray value = QByteArray::fromHex(cmd.toStdString().c_str());
-request(QModbusPdu::WriteSingleRegister, value);
+if (postToBusThread([this]() {Stop();})) return;
 timerUpdate_->stop();
-connectTimer_->stop();
+portWatcher_->stop();
+mutex_.lock();
+stateCommanded_.insert(omronID_, busClock_.elapsed());
+polling_ = false;
+const QList<int> group = groupControl_ ? scheduler_.deviceIds() : QList<int>();
+mutex_.unlock();
+if (group.size() > 1) sendGroupCommand(group, E5ccRegisters::Command::Stop);
+else request(E5ccRegisters::commandRequest(E5ccRegisters::Command::Stop));
+commandedRun_.insert(getOmronID(), false);
 }
 
 void Communication::askTemperature(){
-read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::PV), 2);
-waitForMsec(timing::modbus);
-emit TemperatureUpdated(temperature_);
+read(QModbusDataUnit::HoldingRegisters, E5ccRegisters::PV, E5ccRegisters::at(E5ccRegisters::PV).width, [this](const ModbusResult &result) {
+    if (readReady(result)) emit TemperatureUpdated(temperature_);
+}, ModbusQueue::Lane::High);
 }
 
 void Communication::askSV(){
-read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::SV), 2);
-waitForMsec(timing::modbus);
-emit SVUpdated(SV_);
+read(QModbusDataUnit::HoldingRegisters, E5ccRegisters::SV, E5ccRegisters::at(E5ccRegisters::SV).width, [this](const ModbusResult &result) {
+    if (readReady(result)) emit SVUpdated(SV_);
+});
 }
 
 void Communication::askMV(){
-read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::MV), 2);
-waitForMsec(timing::modbus);
-emit MVUpdated(MV_);
+read(QModbusDataUnit::HoldingRegisters, E5ccRegisters::MV, E5ccRegisters::at(E5ccRegisters::MV).width, [this](const ModbusResult &result) {
+    if (readReady(result)) emit MVUpdated(MV_);
+}, ModbusQueue::Lane::High);
 }
 
 void Communication::askMVupper(){
-read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::MVupper), 2);
-waitForMsec(timing::modbus);
-emit MVupperUpdated(MVupper_);
+read(QModbusDataUnit::HoldingRegisters, E5ccRegisters::MVupper, E5ccRegisters::at(E5ccRegisters::MVupper).width, [this](const ModbusResult &result) {
+    if (readReady(result)) emit MVupperUpdated(MVupper_);
+});
 }
 
 void Communication::askMVlower(){
-read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::MVlower), 2);
-waitForMsec(timing::modbus);
-emit MVlowerUpdated(MVlower_);
+read(QModbusDataUnit::HoldingRegisters, E5ccRegisters::MVlower, E5ccRegisters::at(E5ccRegisters::MVlower).width, [this](const ModbusResult &result) {
+    if (readReady(result)) emit MVlowerUpdated(MVlower_);
+});
 }
 
 /**
 * @brief Asks for the PID value specified by the parameter.
 *
-* If the input parameter is "P", it reads the value of the PID P term, emits the PID_PUpdated signal and
-* stores the result in the variable pid_P_. If the input parameter is "I", it reads the value of the
-* PID I term, emits the PID_IUpdated signal and stores the result in the variable pid_I_. If the input
-* parameter is "D", it reads the value of the PID D term, emits the PID_DUpdated signal and stores the
-* result in the variable pid_D_. If the input parameter is not "P", "I", or "D", it reads the values of
-* all three PID terms, emits all three corresponding signals and stores the results in the corresponding
-* variables pid_P_, pid_I_, and pid_D_.
+* If the input parameter is "P", "I" or "D", only that term is read. Otherwise the three terms,
+* which lie next to each other, are read with one block request. The results are stored in pid_P_,
+* pid_I_ and pid_D_ and the corresponding signals are emitted from the completion handler. The
+* read waits in the low lane, so it never delays the status poll.
 */
 void Communication::askPID(QString PID){
-if (PID == "P"){
-    read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::PID_P), 2);
-    waitForMsec(timing::modbus);
-    emit PID_PUpdated(pid_P_);
-} else if (PID == "I"){
-    read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::PID_I), 2);
-    waitForMsec(timing::modbus);
-    emit PID_IUpdated(pid_I_);
-} else if (PID == "D"){
-    read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::PID_D), 2);
-    waitForMsec(timing::modbus);
-    emit PID_DUpdated(pid_D_);
-} else {
-  read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::PID_P), 2);
-   waitForMsec(2*timing::modbus);
-   emit PID_PUpdated(pid_P_);
-   read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::PID_I), 2);
-   waitForMsec(2*timing::modbus);
-   emit PID_IUpdated(pid_I_);
-   read(QModbusDataUnit::HoldingRegisters, static_cast<int>(E5CC_Address::Type::PID_D), 2);
-   waitForMsec(2*timing::modbus);
-   emit PID_DUpdated(pid_D_);
+const bool all = (PID != "P" && PID != "I" && PID != "D");
+const quint16 first = (all || PID == "P") ? E5ccRegisters::PID_P : (PID == "I") ? E5ccRegisters::PID_I : E5ccRegisters::PID_D;
+const quint16 last = (all || PID == "D") ? E5ccRegisters::PID_D : first;
+const int size = last + E5ccRegisters::at(last).width - first;
+read(QModbusDataUnit::HoldingRegisters, first, size, [this, first, last](const ModbusResult &result) {
+    if (!readReady(result)) return;
+    if (first <= E5ccRegisters::PID_P && E5ccRegisters::PID_P <= last) emit PID_PUpdated(getPID_P());
+    if (first <= E5ccRegisters::PID_I && E5ccRegisters::PID_I <= last) emit PID_IUpdated(getPID_I());
+    if (first <= E5ccRegisters::PID_D && E5ccRegisters::PID_D <= last) emit PID_DUpdated(getPID_D());
+});
 }
+
+void Communication::askSetting(){
+if (postToBusThread([this]() {askSetting();})) return;
+snapshot_->refresh(getOmronID());
+}
+
+/**
+ * @details Values of the controller selected with setOmronID() update the members and drive the
+ * legacy signals. A setting that changes after the first refresh, e.g. on the front panel, is
+ * logged as configuration drift. Monitor values of the operation level change all the time and
+ * are not logged. While the status poll runs, PV, MV and SV are published by finishPoll()
+ * through their change filters instead.
+ */
+void Communication::applySetting(int omronID, quint16 address, double value, bool first){
+const E5ccRegister &reg = E5ccRegisters::at(address);
+if (!first && reg.area != E5ccRegister::Area::Operation) {
+  emit logMsg(tr("Setting changed on device %1: %2= %3").arg(omronID).arg(reg.label()).arg(value));
+}
+if (omronID != getOmronID()) return;
+mutex_.lock();
+if (polling_ && (address == E5ccRegisters::PV || address == E5ccRegisters::MV || address == E5ccRegisters::SV)) {
+  mutex_.unlock();
+  return;
+}
+const struct {quint16 address; double *target; void (Communication::*signal)(double);} variables[] = {
+  {E5ccRegisters::PV, &temperature_, &Communication::TemperatureUpdated}, {E5ccRegisters::MV, &MV_, &Communication::MVUpdated},
+  {E5ccRegisters::SV, &SV_, &Communication::SVUpdated}, {E5ccRegisters::MVupper, &MVupper_, &Communication::MVupperUpdated},
+  {E5ccRegisters::MVlower, &MVlower_, &Communication::MVlowerUpdated}, {E5ccRegisters::PID_P, &pid_P_, &Communication::PID_PUpdated},
+  {E5ccRegisters::PID_I, &pid_I_, &Communication::PID_IUpdated}, {E5ccRegisters::PID_D, &pid_D_, &Communication::PID_DUpdated}
+};
+void (Communication::*signal)(double) = nullptr;
+for (const auto &variable : variables) {
+  if (variable.address != address) continue;
+  *variable.target = value;
+  signal = variable.signal;
+}
+mutex_.unlock();
+if (signal) emit (this->*signal)(value);
 }
 
 void Communication::askStatus(){
-  askTemperature();
-  askMV();
-  int i = 0;
-  while (MV_ == temperature_){
-    waitForMsec(200);
-    askMV();
-    i++;
-    if (i > 10) break;
+  if (statusPending_ > 0) return;
+  pollDevice(getOmronID());
+}
+
+/**
+ * @details The BusScheduler picks the due controller with the smallest share of the line so far.
+ * Only one status cycle is on the bus at a time, so the poll rate of each device drops in
+ * proportion to the number of devices once the line is saturated.
+ */
+void Communication::pollNext(){
+  if (statusPending_ > 0) return;
+  mutex_.lock();
+  const int omronID = scheduler_.next(busClock_.elapsed());
+  mutex_.unlock();
+  if (omronID < 0) {
+    schedulePoll();
+    return;
   }
-  askSV();
-  emit statusUpdate();
+  pollDevice(omronID);
+}
+
+/**
+ * @details The PollSchedule picks the due registers of the controller and packs them into
+ * contiguous windows, so one status cycle costs one ReadHoldingRegisters request per window
+ * instead of one per variable. The windows are queued back to back and the sample is published
+ * once the last reply is in. A value that is not due in this cycle is taken from the
+ * configuration snapshot, which every reply updates, so slow settings such as the MV limits and
+ * PID stay fresh and their changes are published through applySetting().
+ */
+void Communication::pollDevice(int omronID){
+  mutex_.lock();
+  const QVector<ModbusBlock> blocks = pollSchedule_.plan(omronID, busClock_.elapsed());
+  mutex_.unlock();
+  if (blocks.isEmpty()) {
+    schedulePoll();
+    return;
+  }
+  QSharedPointer<DeviceSample> sample(new DeviceSample);
+  sample->omronID = omronID;
+  sample->temperature = snapshot_->entry(omronID, E5ccRegisters::PV).value;
+  sample->MV = snapshot_->entry(omronID, E5ccRegisters::MV).value;
+  sample->SV = snapshot_->entry(omronID, E5ccRegisters::SV).value;
+  sample->heaterCurrent = snapshot_->entry(omronID, E5ccRegisters::HeaterCurrent).value;
+  sample->status = static_cast<quint32>(snapshot_->entry(omronID, E5ccRegisters::Status).raw);
+  sample->statusValid = snapshot_->entry(omronID, E5ccRegisters::Status).valid;
+  statusPending_ = blocks.size();
+  pollStarted_ = busClock_.elapsed();
+  for (const ModbusBlock &block : blocks) {
+    readDevice(omronID, QModbusPdu::ReadHoldingRegisters, block.start, block.count, [this, sample](const ModbusResult &result) {
+      if (checkRead(result)) {
+        const quint16 start = result.startAddress();
+        const QVector<quint16> values = result.values();
+        E5ccRegisters::at(E5ccRegisters::PV).decodeFrom(start, values, sample->temperature, tempDecimal_);
+        E5ccRegisters::at(E5ccRegisters::MV).decodeFrom(start, values, sample->MV, tempDecimal_);
+        E5ccRegisters::at(E5ccRegisters::SV).decodeFrom(start, values, sample->SV, tempDecimal_);
+        E5ccRegisters::at(E5ccRegisters::HeaterCurrent).decodeFrom(start, values, sample->heaterCurrent);
+        double status = 0.0;
+        if (E5ccRegisters::at(E5ccRegisters::Status).decodeFrom(start, values, status)) {
+          sample->status = static_cast<quint32>(status);
+          sample->statusValid = true;
+        }
+        mutex_.lock();
+        pollSchedule_.markRead(sample->omronID, start, values.size(), busClock_.elapsed());
+        mutex_.unlock();
+        snapshot_->update(sample->omronID, start, values);
+        verifyReadBack(sample->omronID, start, values);
+      } else {
+        sample->valid = false;
+      }
+      if (--statusPending_ > 0) return;
+      finishPoll(*sample);
+    });
+  }
+}
+
+/**
+ * @details The controller selected with setOmronID() keeps driving the legacy signals, so the
+ * main window works unchanged while more controllers share the line. Every value passes its
+ * ChangeFilter first, so listeners only wake up when a value has moved or the heartbeat is due.
+ * The status word is published when one of its bits has changed. A poll that started before the
+ * last run, stop or AT command to the controller may still show the old state, so its status is
+ * not published; neither is a status that arrives after the polling was stopped.
+ */
+void Communication::finishPoll(const DeviceSample &sample){
+  DeviceSample done = sample;
+  done.timestamp = QDateTime::currentDateTime();
+  mutex_.lock();
+  busBusy_ += busClock_.elapsed() - pollStarted_;
+  const bool primary = (done.omronID == omronID_);
+  if (primary && done.valid) {
+    temperature_ = done.temperature;
+    MV_ = done.MV;
+    SV_ = done.SV;
+    heaterCurrent_ = done.heaterCurrent;
+  }
+  int interval = -1;
+  if (done.valid) {
+    const double slope = updateSlope(done);
+    const BusScheduler::Device *device = scheduler_.device(done.omronID);
+    if (adaptivePolling_ && device && slope >= 0.0) {
+      const int adapted = adaptInterval(done, slope, device->interval);
+      if (adapted != device->interval) {
+        scheduler_.setInterval(done.omronID, adapted);
+        interval = adapted;
+      }
+    }
+  }
+  bool changed[4] = {false, false, false, false};
+  bool sampled = false;
+  if (done.valid) {
+    const qint64 now = busClock_.elapsed();
+    const double values[4] = {done.temperature, done.MV, done.SV, done.heaterCurrent};
+    for (int i = 0; i < 4; i++) {
+      changed[i] = filters_[i].accept(done.omronID, values[i], now);
+      if (sampleFilters_[i].accept(done.omronID, values[i], now)) sampled = true;
+    }
+  }
+  quint32 statusChanged = 0;
+  if (done.valid && done.statusValid && polling_ && pollStarted_ > stateCommanded_.value(done.omronID, -1)) {
+    const auto last = lastStatus_.constFind(done.omronID);
+    statusChanged = (last == lastStatus_.cend()) ? ~0u : (*last ^ done.status);
+    lastStatus_.insert(done.omronID, done.status);
+  }
+  mutex_.unlock();
+  if (sampled) emit sampleUpdated(done);
+  if (interval >= 0) emit pollIntervalChanged(done.omronID, interval);
+  if (statusChanged) emit deviceStatusChanged(done.omronID, done.status, statusChanged);
+  if (primary) {
+    if (changed[static_cast<int>(Channel::Temperature)]) emit TemperatureUpdated(done.temperature);
+    if (changed[static_cast<int>(Channel::MV)]) emit MVUpdated(done.MV);
+    if (changed[static_cast<int>(Channel::SV)]) emit SVUpdated(done.SV);
+    if (changed[static_cast<int>(Channel::HeaterCurrent)]) emit HeaterCurrentUpdated(done.heaterCurrent);
+    if (done.valid) emit heaterSampled(done.MV, done.heaterCurrent);
+    if (statusChanged & E5ccRegisters::runStop) emit runStateChanged(!(done.status & E5ccRegisters::runStop));
+    if (statusChanged & E5ccRegisters::atExecute) emit autotuningChanged(done.status & E5ccRegisters::atExecute);
+    if (statusChanged & (E5ccRegisters::heaterBurnout | E5ccRegisters::inputError | E5ccRegisters::alarm1 | E5ccRegisters::alarm2)) {
+      emit alarmStateChanged(done.status);
+    }
+    emit statusUpdate();
+  }
+  schedulePoll();
+}
+
+void Communication::schedulePoll(){
+  QMutexLocker locker(&mutex_);
+  if (!polling_ || statusPending_ > 0) return;
+  const qint64 due = scheduler_.nextDue();
+  if (due < 0) return;
+  const qint64 wait = qMax<qint64>(0, due - busClock_.elapsed());
+  timerUpdate_->start(static_cast<int>(wait));
+}
+
+/**
+ * @details The difference between two samples is reduced by one count of the display resolution,
+ * so the quantization of PV alone does not look like a ramp. The slope is smoothed exponentially.
+ */
+double Communication::updateSlope(const DeviceSample &sample){
+  const bool known = lastSamples_.contains(sample.omronID);
+  const DeviceSample previous = lastSamples_.value(sample.omronID);
+  lastSamples_.insert(sample.omronID, sample);
+  if (!known) return -1.0;
+  const qint64 elapsed = previous.timestamp.msecsTo(sample.timestamp);
+  if (elapsed <= 0) return slopes_.value(sample.omronID, -1.0);
+  const double change = qMax(0.0, qAbs(sample.temperature - previous.temperature) - tempDecimal_);
+  const double slope = change * 60000.0 / elapsed;
+  const double smoothed = slopes_.contains(sample.omronID)
+      ? slopeWeight * slope + (1.0 - slopeWeight) * slopes_.value(sample.omronID) : slope;
+  slopes_.insert(sample.omronID, smoothed);
+  return smoothed;
+}
+
+/**
+ * @details The urgency is the largest of three criteria, each between 0 and 1: the slope between
+ * steadySlope and rampSlope, the closeness to the safety limit within limitBand, and MV sitting
+ * at MVupper. An urgent process is polled between the update interval and the lower bound. A
+ * steady process backs off by half the current interval per poll until the upper bound is reached.
+ * Anything in between is polled with the update interval.
+ */
+int Communication::adaptInterval(const DeviceSample &sample, double slope, int current) const {
+  double urgency = qBound(0.0, (slope - steadySlope) / (rampSlope - steadySlope), 1.0);
+  urgency = qMax(urgency, qBound(0.0, 1.0 - (safetyLimit_ - sample.temperature) / limitBand, 1.0));
+  if (sample.omronID == omronID_ && MVupper_ > 0.0 && sample.MV >= MVupper_ - mvMargin) urgency = 1.0;
+  int interval = intervalUpdate_;
+  if (urgency > 0.0) {
+    interval = intervalUpdate_ - static_cast<int>(urgency * (intervalUpdate_ - minIntervalUpdate_));
+  } else if (slope < steadySlope) {
+    interval = qMax(current, intervalUpdate_) + current / 2;
+  }
+  return qBound(minIntervalUpdate_, interval, maxIntervalUpdate_);
+}
+
+void Communication::addPollDevice(int omronID, int priority){
+  if (postToBusThread([=]() {addPollDevice(omronID, priority);})) return;
+  mutex_.lock();
+  scheduler_.addDevice(omronID, priority, intervalUpdate_);
+  scheduler_.trigger(omronID, busClock_.elapsed());
+  mutex_.unlock();
+  schedulePoll();
+}
+
+void Communication::removePollDevice(int omronID){
+  if (postToBusThread([=]() {removePollDevice(omronID);})) return;
+  QMutexLocker locker(&mutex_);
+  scheduler_.removeDevice(omronID);
+}
+
+void Communication::setPollPriority(int omronID, int priority){
+  if (postToBusThread([=]() {setPollPriority(omronID, priority);})) return;
+  QMutexLocker locker(&mutex_);
+  scheduler_.setPriority(omronID, priority);
 }
 
 void Communication::changeMVlowerValue(double MVlower){
-if(!modbusReady_) return;
+if (postToBusThread([=]() {changeMVlowerValue(MVlower);})) return;
 setMVlower(MVlower);
-int sv = (qint16) (MVlower / tempDecimal_ + 0.5);
-QString valueStr = formatHex(sv, 8);
-QString addressStr = formatHex(static_cast<int>(E5CC_Address::Type::MVlower), 4);
-QString cmd = addressStr + " 00 02 04" + valueStr;
-QByteArray value = QByteArray::fromHex(cmd.toStdString().c_str());
-request(QModbusPdu::WriteMultipleRegisters, value);
+const E5ccRegister &reg = E5ccRegisters::at(E5ccRegisters::MVlower);
+commanded_.insert(readBackKey(getOmronID(), reg.address), reg.encode(MVlower, tempDecimal_));
+writer_->write(getOmronID(), reg.address, reg.encode(MVlower, tempDecimal_));
 }
 
 void Communication::changeMVupperValue(double MVupper){
-if(!modbusReady_) return;;
+if (postToBusThread([=]() {changeMVupperValue(MVupper);})) return;
 setMVupper(MVupper);
-int sv = (qint16) (MVupper / tempDecimal_ + 0.5);
-QString valueStr = formatHex(sv, 8);
-QString addressStr = formatHex(static_cast<int>(E5CC_Address::Type::MVupper), 4);
-QString cmd = addressStr + " 00 02 04" + valueStr;
-QByteArray value = QByteArray::fromHex(cmd.toStdString().c_str());
-request(QModbusPdu::WriteMultipleRegisters, value);
+const E5ccRegister &reg = E5ccRegisters::at(E5ccRegisters::MVupper);
+commanded_.insert(readBackKey(getOmronID(), reg.address), reg.encode(MVupper, tempDecimal_));
+writer_->write(getOmronID(), reg.address, reg.encode(MVupper, tempDecimal_));
 }
 
 void Communication::changeSVValue(double SV){
-int sv_input = (qint16) (SV /tempDecimal_ + 0.5);
-QString valueStr = formatHex(sv_input, 8);
-QString addressStr = formatE5CCAddress(E5CC_Address::Type::SV);
-QString cmd = addressStr + " 00 02 04" + valueStr;
-QByteArray value = QByteArray::fromHex(cmd.toStdString().c_str());
-request(QModbusPdu::WriteMultipleRegisters, value);
-}
-
-void Communication::checkConnection(){
-const auto currentPorts = QSerialPortInfo::availablePorts();
-for (const auto& port : currentPorts){
-  if (!infos_.contains(port) ){
-  infos_.append(port);
+if (postToBusThread([=]() {changeSVValue(SV);})) return;
+const E5ccRegister &reg = E5ccRegisters::at(E5ccRegisters::SV);
+commanded_.insert(readBackKey(getOmronID(), reg.address), reg.encode(SV, tempDecimal_));
+writer_->write(getOmronID(), reg.address, reg.encode(SV, tempDecimal_));
+}
+
+void Communication::sendGroupSV(const QList<int> &omronIDs, double SV){
+if (postToBusThread([=]() {sendGroupSV(omronIDs, SV);})) return;
+const E5ccRegister &reg = E5ccRegisters::at(E5ccRegisters::SV);
+const qint32 raw = reg.encode(SV, tempDecimal_);
+if (isBroadcastGroup(omronIDs)) writer_->writeBroadcast(omronIDs, reg.address, raw);
+else writer_->write(omronIDs, reg.address, raw);
+for (const int omronID : omronIDs) {
+  commanded_.insert(readBackKey(omronID, reg.address), raw);
+  expect(omronID, reg.address, 0xFFFFFFFFu, static_cast<quint32>(raw));
+}
+}
+
+/**
+ * @details Run and stop use the high lane like the single commands, autotuning the low lane.
+ */
+void Communication::sendGroupCommand(const QList<int> &omronIDs, E5ccRegisters::Command command){
+if (postToBusThread([=]() {sendGroupCommand(omronIDs, command);})) return;
+quint32 mask = E5ccRegisters::runStop;
+quint32 value = 0;
+ModbusQueue::Lane lane = ModbusQueue::Lane::High;
+switch (command) {
+  case E5ccRegisters::Command::Run: break;
+  case E5ccRegisters::Command::Stop: value = E5ccRegisters::runStop; break;
+  case E5ccRegisters::Command::ATCancel: mask = E5ccRegisters::atExecute; lane = ModbusQueue::Lane::Low; break;
+  case E5ccRegisters::Command::AT100:
+  case E5ccRegisters::Command::AT40: mask = value = E5ccRegisters::atExecute; lane = ModbusQueue::Lane::Low; break;
+}
+const QModbusRequest ask = E5ccRegisters::commandRequest(command);
+if (isBroadcastGroup(omronIDs)) {
+  queue_->enqueue(ask, broadcastAddress, ModbusQueue::Handler(), lane);
+} else {
+  for (const int omronID : omronIDs) {
+    queue_->enqueue(ask, omronID, [this](const ModbusResult &result) {
+      if (!result.isValid()) emit statusMessage(tr("Group command to device %1 failed: %2").arg(result.serverAddress).arg(result.errorString), 0);
+    }, lane);
   }
 }
-if (isSerialPortRemoved_) return;
-for (const QSerialPortInfo& port : qAsConst(infos_)) {
-  if (!currentPorts.contains(port)) {
-    emit serialPortRemove("USB connection lost. <<Correctly, COM port has been deleted.>>"
-                          "Communication with the application may not be possible. "
-                          "Please come to the laboratory as soon as possible.");
-    isSerialPortRemoved_ = true;
+for (const int omronID : omronIDs) {
+  if (command == E5ccRegisters::Command::Run || command == E5ccRegisters::Command::Stop) {
+    commandedRun_.insert(omronID, command == E5ccRegisters::Command::Run);
   }
+  mutex_.lock();
+  stateCommanded_.insert(omronID, busClock_.elapsed());
+  mutex_.unlock();
+  expect(omronID, E5ccRegisters::Status, mask, value);
 }
 }
 
-bool Communication::isTimerUpdateRunning() const {return timerUpdate_->isActive();}
+bool Communication::isBroadcastGroup(const QList<int> &omronIDs) const {
+QMutexLocker locker(&mutex_);
+if (!broadcastWrites_ || omronIDs.size() < 2) return false;
+QList<int> polled = scheduler_.deviceIds();
+QList<int> group = omronIDs;
+std::sort(polled.begin(), polled.end());
+std::sort(group.begin(), group.end());
+group.erase(std::unique(group.begin(), group.end()), group.end());
+return polled == group;
+}
+
+void Communication::expect(int omronID, quint16 address, quint32 mask, quint32 value){
+Expectation expectation;
+expectation.mask = mask;
+expectation.value = value & mask;
+expectation.checks = readBackChecks;
+expectations_.insert(readBackKey(omronID, address), expectation);
+requestReadBack(omronID, address);
+}
+
+/**
+ * @details A polled controller reads the register with its next poll, which is made due at once,
+ * so the read-back follows the write on the bus without an extra request of its own.
+ */
+void Communication::requestReadBack(int omronID, quint16 address, int delay){
+mutex_.lock();
+const bool polled = polling_ && scheduler_.contains(omronID);
+if (polled) {
+  pollSchedule_.request(omronID, address);
+  if (delay == 0) scheduler_.trigger(omronID, busClock_.elapsed());
+}
+mutex_.unlock();
+if (polled) {
+  schedulePoll();
+  return;
+}
+QTimer::singleShot(delay, this, [this, omronID, address]() {
+  readDevice(omronID, QModbusPdu::ReadHoldingRegisters, address, E5ccRegisters::at(address).width, [this, omronID, address](const ModbusResult &result) {
+    if (result.isValid()) {
+      verifyReadBack(omronID, result.startAddress(), result.values());
+      return;
+    }
+    auto it = expectations_.find(readBackKey(omronID, address));
+    if (it == expectations_.end()) return;
+    if (--it->checks > 0) {
+      requestReadBack(omronID, address, readBackDelay);
+      return;
+    }
+    expectations_.erase(it);
+    emit groupWriteVerified(omronID, address, false);
+  });
+});
+}
+
+/**
+ * @details A mismatch is checked again, since a controller may take a moment to apply a
+ * broadcast. After readBackChecks mismatches the write counts as failed.
+ */
+void Communication::verifyReadBack(int omronID, quint16 start, const QVector<quint16> &values){
+ModbusBlock block;
+block.start = start;
+block.count = static_cast<quint16>(values.size());
+for (auto it = expectations_.begin(); it != expectations_.end();) {
+  const quint16 address = static_cast<quint16>(it.key() & 0xFFFF);
+  if (static_cast<int>(it.key() >> 16) != omronID || !block.contains(address)) {
+    ++it;
+    continue;
+  }
+  const bool ok = (static_cast<quint32>(block.doubleWord(values, address)) & it->mask) == it->value;
+  if (!ok && --it->checks > 0) {
+    requestReadBack(omronID, address, readBackDelay);
+    ++it;
+    continue;
+  }
+  it = expectations_.erase(it);
+  if (!ok) emit logMsg(tr("Group write to device %1 not applied: %2").arg(omronID).arg(E5ccRegisters::at(address).label()));
+  emit groupWriteVerified(omronID, address, ok);
+}
+}
+
+/**
+ * @details Only the port in use counts; a Modbus TCP or replay endpoint has no serial port. The
+ * loss is reported once, until the adapter is plugged in again.
+ */
+void Communication::serialPortRemoved(const QString &portName){
+mutex_.lock();
+for (int i = infos_.size() - 1; i >= 0; i--) {
+  if (infos_.at(i).portName() == portName) infos_.removeAt(i);
+}
+const bool inUse = (portName == portName_);
+mutex_.unlock();
+if (!inUse || isSerialPortRemoved_) return;
+emit serialPortRemove("USB connection lost. <<Correctly, COM port has been deleted.>>"
+                      "Communication with the application may not be possible. "
+                      "Please come to the laboratory as soon as possible.");
+isSerialPortRemoved_ = true;
+}
+
+void Communication::serialPortAdded(const QString &portName){
+const QSerialPortInfo info(portName);
+mutex_.lock();
+if (!infos_.contains(info)) infos_.append(info);
+const bool inUse = (portName == portName_);
+mutex_.unlock();
+if (!inUse || !isSerialPortRemoved_) return;
+isSerialPortRemoved_ = false;
+emit logMsg(tr("Serial port %1 is present again").arg(portName));
+transport_->reconnectNow();
+}
+
+/**
+ * @details The run state, SV and MV limits of every controller the application has commanded are
+ * read back. A value that differs from the last command, e.g. because the controller lost power
+ * together with the adapter, is written again. The recovery time runs from the loss of the link
+ * until every controller has been checked; it is published with connectionRecovered(). A link
+ * that drops again meanwhile keeps the original loss time and starts over on the next reconnect.
+ */
+void Communication::resynchronize(){
+QList<int> omronIDs = commandedRun_.keys();
+for (auto it = commanded_.cbegin(); it != commanded_.cend(); ++it) {
+  const int omronID = static_cast<int>(it.key() >> 16);
+  if (!omronIDs.contains(omronID)) omronIDs.append(omronID);
+}
+if (!omronIDs.contains(getOmronID())) omronIDs.append(getOmronID());
+const qint64 lostAt = lostAt_;
+const quint16 starts[] = {E5ccRegisters::PV, E5ccRegisters::SV, E5ccRegisters::MVupper};
+const quint16 counts[] = {4, 2, 4};
+auto pending = QSharedPointer<int>::create(omronIDs.size() * 3);
+auto failed = QSharedPointer<int>::create(0);
+auto done = [this, lostAt, pending, failed](const ModbusResult &result) {
+  if (!result.isValid()) ++*failed;
+  if (--*pending > 0 || lostAt_ != lostAt || !transport_->isConnected()) return;
+  const qint64 recovery = busClock_.elapsed() - lostAt;
+  lostAt_ = -1;
+  mutex_.lock();
+  recoveries_++;
+  lastRecovery_ = recovery;
+  if (scheduler_.contains(omronID_)) scheduler_.trigger(omronID_, busClock_.elapsed());
+  mutex_.unlock();
+  schedulePoll();
+  if (*failed > 0) emit logMsg(tr("%1 read-backs failed after the reconnect, the state is not fully verified").arg(*failed));
+  emit logMsg(tr("Connection recovered in %1 s").arg(recovery / 1000.0, 0, 'f', 1));
+  emit connectionRecovered(recovery);
+};
+for (const int omronID : omronIDs) {
+  for (int i = 0; i < 3; i++) {
+    readDevice(omronID, QModbusPdu::ReadHoldingRegisters, starts[i], counts[i], [this, omronID, done](const ModbusResult &result) {
+      if (result.isValid()) {
+        snapshot_->update(omronID, result.startAddress(), result.values());
+        restoreCommanded(omronID, result.startAddress(), result.values());
+      }
+      done(result);
+    });
+  }
+}
+}
+
+void Communication::restoreCommanded(int omronID, quint16 start, const QVector<quint16> &values){
+if (commandedRun_.contains(omronID) && start <= E5ccRegisters::Status && start + values.size() >= E5ccRegisters::Status + 2) {
+  const int offset = E5ccRegisters::Status - start;
+  const quint32 status = (static_cast<quint32>(values.at(offset)) << 16) | values.at(offset + 1);
+  const bool running = !(status & E5ccRegisters::runStop);
+  const bool commanded = commandedRun_.value(omronID);
+  if (running != commanded) {
+    emit logMsg(tr("Device %1 is %2 after the reconnect, restoring %3").arg(omronID)
+                .arg(running ? "running" : "stopped").arg(commanded ? "run" : "stop"));
+    queue_->enqueue(E5ccRegisters::commandRequest(commanded ? E5ccRegisters::Command::Run : E5ccRegisters::Command::Stop), omronID);
+  }
+}
+for (const quint16 address : {E5ccRegisters::SV, E5ccRegisters::MVupper, E5ccRegisters::MVlower}) {
+  const auto it = commanded_.constFind(readBackKey(omronID, address));
+  if (it == commanded_.cend()) continue;
+  const E5ccRegister &reg = E5ccRegisters::at(address);
+  double value = 0.0;
+  if (!reg.decodeFrom(start, values, value, tempDecimal_) || reg.encode(value, tempDecimal_) == *it) continue;
+  emit logMsg(tr("Device %1: %2 is %3 after the reconnect, restoring %4").arg(omronID).arg(reg.label()).arg(value)
+              .arg(reg.decode(static_cast<quint32>(*it), tempDecimal_)));
+  writer_->write(omronID, address, *it);
+}
+}
+
+void Communication::setGateway(int port){
+if (postToBusThread([=]() {setGateway(port);})) return;
+gateway_->close();
+if (port > 0) {
+  gateway_->setDefaultServer(getOmronID());
+  if (gateway_->listen(static_cast<quint16>(port))) {
+    emit logMsg(tr("Modbus TCP gateway listening on localhost:%1").arg(port));
+  } else {
+    emit logMsg(tr("Modbus TCP gateway cannot listen on port %1: %2").arg(port).arg(gateway_->errorString()));
+    port = 0;
+  }
+} else {
+  emit logMsg(tr("Modbus TCP gateway closed after %1 cached and %2 forwarded requests")
+              .arg(gateway_->cacheHits()).arg(gateway_->forwarded()));
+}
+mutex_.lock();
+gatewayPort_ = port;
+mutex_.unlock();
+emit gatewayChanged(port);
+}
+
+/**
+ * @details The controller has accepted the values, so they are stored in the cache right away and
+ * a client reading them back is not served the value from before the write. A command written to
+ * 0x0000 shares its address with PV, so instead the status word is read with the next poll.
+ * Values the application has commanded itself follow the client, so a reconnect does not restore
+ * the value from before the write.
+ */
+void Communication::applyGatewayWrite(int omronID, quint16 start, const QVector<quint16> &values){
+if (start == E5ccRegisters::OperationCommand) {
+  mutex_.lock();
+  pollSchedule_.request(omronID, E5ccRegisters::Status);
+  mutex_.unlock();
+  emit logMsg(tr("Gateway client sent command 0x%1 to device %2").arg(values.value(0), 4, 16, QChar('0')).arg(omronID));
+  return;
+}
+snapshot_->update(omronID, start, values);
+for (int i = start % ModbusBlock::width; i + 1 < values.size(); i += ModbusBlock::width) {
+  const auto it = commanded_.find(readBackKey(omronID, static_cast<quint16>(start + i)));
+  if (it != commanded_.end()) *it = static_cast<qint32>((static_cast<quint32>(values.at(i)) << 16) | values.at(i + 1));
+}
+emit logMsg(tr("Gateway client wrote %1 register(s) at 0x%2 of device %3").arg(values.size()).arg(start, 4, 16, QChar('0')).arg(omronID));
+}
+
+bool Communication::isTimerUpdateRunning() const {QMutexLocker locker(&mutex_); return polling_;}
 
 // setter methods
-void Communication::setSerialPortName(QString portName){portName_ = portName;}
-void Communication::setTemperature(double temperature){temperature_ = temperature;}
-void Communication::setSV(double SV){SV_ = SV;}
-void Communication::setMV(double MV){MV_ = MV;}
-void Communication::setMVupper(double MVupper){MVupper_ = MVupper;}
-void Communication::setMVlower(double MVlower){MVlower_ = MVlower;}
-void Communication::setOmronID(int OmronID){omronID_ = OmronID;}
-void Communication::setIntervalUpdate(int interval){intervalUpdate_ = interval;}
-void Communication::setIntervalConectionCheck(int interval){intervalConectionCheck_ = interval;}
+void Communication::setSerialPortName(QString portName){QMutexLocker locker(&mutex_); portName_ = portName;}
+void Communication::setSerialSettings(int baudRate, int parity, int stopBits){QMutexLocker locker(&mutex_); baudRate_ = baudRate; parity_ = parity; stopBits_ = stopBits;}
+void Communication::setAutoProbe(bool enable){QMutexLocker locker(&mutex_); autoProbe_ = enable;}
+void Communication::setTemperature(double temperature){QMutexLocker locker(&mutex_); temperature_ = temperature;}
+void Communication::setSV(double SV){QMutexLocker locker(&mutex_); SV_ = SV;}
+void Communication::setMV(double MV){QMutexLocker locker(&mutex_); MV_ = MV;}
+void Communication::setMVupper(double MVupper){QMutexLocker locker(&mutex_); MVupper_ = MVupper;}
+void Communication::setMVlower(double MVlower){QMutexLocker locker(&mutex_); MVlower_ = MVlower;}
+void Communication::setOmronID(int OmronID){QMutexLocker locker(&mutex_); omronID_ = OmronID; gateway_->setDefaultServer(OmronID);}
+void Communication::setIntervalUpdate(int interval){QMutexLocker locker(&mutex_); intervalUpdate_ = interval; scheduler_.setIntervalAll(interval);}
+void Communication::setIntervalConectionCheck(int interval){QMutexLocker locker(&mutex_); intervalConectionCheck_ = interval;}
+void Communication::setSafetyLimit(double limit){QMutexLocker locker(&mutex_); safetyLimit_ = limit;}
+void Communication::setBroadcastWrites(bool enable){QMutexLocker locker(&mutex_); broadcastWrites_ = enable;}
+void Communication::setGroupControl(bool enable){QMutexLocker locker(&mutex_); groupControl_ = enable;}
+
+void Communication::setRegisterPoll(quint16 address, int period, int priority){
+  QMutexLocker locker(&mutex_);
+  if (!E5ccRegisters::find(address)) return;
+  pollSchedule_.setRule(address, period, priority);
+}
+
+void Communication::setChangeFilter(Channel channel, double absolute, double relative, int heartbeat){
+  QMutexLocker locker(&mutex_);
+  ChangeFilter &filter = filters_[static_cast<int>(channel)];
+  filter.setDeadband(absolute, relative);
+  filter.setHeartbeat(heartbeat);
+}
+
+void Communication::setSampleFilter(Channel channel, double absolute, double relative, int heartbeat){
+  QMutexLocker locker(&mutex_);
+  ChangeFilter &filter = sampleFilters_[static_cast<int>(channel)];
+  filter.setDeadband(absolute, relative);
+  filter.setHeartbeat(heartbeat);
+}
+
+void Communication::setAdaptivePolling(bool enable){
+  QMutexLocker locker(&mutex_);
+  adaptivePolling_ = enable;
+  if (!enable) scheduler_.setIntervalAll(intervalUpdate_);
+}
+
+void Communication::setIntervalUpdateBounds(int minInterval, int maxInterval){
+  QMutexLocker locker(&mutex_);
+  minIntervalUpdate_ = qMax(1, qMin(minInterval, maxInterval));
+  maxIntervalUpdate_ = qMax(minInterval, maxInterval);
+}
+
+void Communication::loadPollSettings(){
+  QSettings settings;
+  settings.beginGroup(pollGroup);
+  setAdaptivePolling(settings.value("adaptive", isAdaptivePolling()).toBool());
+  mutex_.lock();
+  const int minInterval = minIntervalUpdate_;
+  const int maxInterval = maxIntervalUpdate_;
+  mutex_.unlock();
+  setIntervalUpdateBounds(settings.value("minInterval", minInterval).toInt(), settings.value("maxInterval", maxInterval).toInt());
+  settings.endGroup();
+  const int size = settings.beginReadArray(registerPolls);
+  for (int i = 0; i < size; i++) {
+    settings.setArrayIndex(i);
+    const int address = settings.value("address", -1).toInt();
+    if (address < 0 || address > 0xFFFF) continue;
+    setRegisterPoll(static_cast<quint16>(address), qMax(0, settings.value("period").toInt()), settings.value("priority", 1).toInt());
+  }
+  settings.endArray();
+
+  const QVector<PollSchedule::Rule> rules = getRegisterPolls();
+  settings.beginGroup(pollGroup);
+  settings.setValue("adaptive", isAdaptivePolling());
+  mutex_.lock();
+  settings.setValue("minInterval", minIntervalUpdate_);
+  settings.setValue("maxInterval", maxIntervalUpdate_);
+  mutex_.unlock();
+  settings.endGroup();
+  settings.remove(registerPolls);
+  settings.beginWriteArray(registerPolls, rules.size());
+  for (int i = 0; i < rules.size(); i++) {
+    settings.setArrayIndex(i);
+    settings.setValue("address", rules.at(i).address);
+    settings.setValue("period", rules.at(i).period);
+    settings.setValue("priority", rules.at(i).priority);
+  }
+  settings.endArray();
+
+  QMutexLocker locker(&mutex_);
+  ChangeFilter *const sets[] = {filters_, sampleFilters_};
+  for (int set = 0; set < 2; set++) {
+    for (int channel = 0; channel < 4; channel++) {
+      ChangeFilter &filter = sets[set][channel];
+      settings.beginGroup(QString("%1/%2").arg(filterGroups[set], channelNames[channel]));
+      filter.setDeadband(settings.value("absolute", filter.absolute()).toDouble(), settings.value("relative", filter.relative()).toDouble());
+      filter.setHeartbeat(settings.value("heartbeat", filter.heartbeat()).toInt());
+      settings.setValue("absolute", filter.absolute());
+      settings.setValue("relative", filter.relative());
+      settings.setValue("heartbeat", filter.heartbeat());
+      settings.endGroup();
+    }
+  }
+}
 
 
 // getter methods
-QModbusRtuSerialMaster* Communication::getOmron() const {return omron_;}
-QList<QSerialPortInfo> Communication::getSerialPortDevices() const {return infos_;}
-QString Communication::getPortName() const {return portName_;}
-double Communication::getTemperature() const {return temperature_;}
-double Communication::getMV() const {return MV_;}
-double Communication::getSV() const {return SV_;}
-double Communication::getMVupper() const {return MVupper_;}
-double Communication::getMVlower() const {return MVlower_;}
-double Communication::getPID_P() const {return pid_P_;}
-double Communication::getPID_I() const {return pid_I_;}
-double Communication::getPID_D() const {return pid_D_;}
-int Communication::getOmronID() const {return omronID_;}
-int Communication::getIntervalUpdate() const {return intervalUpdate_;}
-int Communication::getIntervalConectionCheck() const {return intervalConectionCheck_;}
+ModbusTransport* Communication::getTransport() const {return transport_;}
+ModbusStats* Communication::getStats() {return &stats_;}
+bool Communication::startCapture(const QString &fileName){return capture_.start(fileName);}
+void Communication::stopCapture(){capture_.stop();}
+bool Communication::isCapturing() const {return capture_.isRecording();}
+int Communication::getRecoveryCount() const {QMutexLocker locker(&mutex_); return recoveries_;}
+qint64 Communication::getLastRecoveryTime() const {QMutexLocker locker(&mutex_); return lastRecovery_;}
+quint32 Communication::getDeviceStatus(int omronID) const {QMutexLocker locker(&mutex_); return lastStatus_.value(omronID);}
+int Communication::getGatewayPort() const {QMutexLocker locker(&mutex_); return gatewayPort_;}
+void Communication::setGatewayMaxAge(int maxAge){gateway_->setMaxAge(maxAge);}
+ConfigSnapshot* Communication::getSnapshot() const {return snapshot_;}
+QList<QSerialPortInfo> Communication::getSerialPortDevices() const {QMutexLocker locker(&mutex_); return infos_;}
+QString Communication::getPortName() const {QMutexLocker locker(&mutex_); return portName_;}
+int Communication::getBaudRate() const {QMutexLocker locker(&mutex_); return baudRate_;}
+int Communication::getParity() const {QMutexLocker locker(&mutex_); return parity_;}
+int Communication::getStopBits() const {QMutexLocker locker(&mutex_); return stopBits_;}
+bool Communication::isAutoProbe() const {QMutexLocker locker(&mutex_); return autoProbe_;}
+double Communication::getTemperature() const {QMutexLocker locker(&mutex_); return temperature_;}
+double Communication::getMV() const {QMutexLocker locker(&mutex_); return MV_;}
+double Communication::getHeaterCurrent() const {QMutexLocker locker(&mutex_); return heaterCurrent_;}
+double Communication::getSV() const {QMutexLocker locker(&mutex_); return SV_;}
+double Communication::getMVupper() const {QMutexLocker locker(&mutex_); return MVupper_;}
+double Communication::getMVlower() const {QMutexLocker locker(&mutex_); return MVlower_;}
+double Communication::getPID_P() const {QMutexLocker locker(&mutex_); return pid_P_;}
+double Communication::getPID_I() const {QMutexLocker locker(&mutex_); return pid_I_;}
+double Communication::getPID_D() const {QMutexLocker locker(&mutex_); return pid_D_;}
+int Communication::getOmronID() const {QMutexLocker locker(&mutex_); return omronID_;}
+int Communication::getIntervalUpdate() const {QMutexLocker locker(&mutex_); return intervalUpdate_;}
+int Communication::getIntervalConectionCheck() const {QMutexLocker locker(&mutex_); return intervalConectionCheck_;}
 QTimer* Communication::getTimerUpdate() const {return timerUpdate_;}
+QList<int> Communication::getPollDevices() const {QMutexLocker locker(&mutex_); return scheduler_.deviceIds();}
+bool Communication::isAdaptivePolling() const {QMutexLocker locker(&mutex_); return adaptivePolling_;}
+bool Communication::isBroadcastWrites() const {QMutexLocker locker(&mutex_); return broadcastWrites_;}
+bool Communication::isGroupControl() const {QMutexLocker locker(&mutex_); return groupControl_;}
+QVector<PollSchedule::Rule> Communication::getRegisterPolls() const {QMutexLocker locker(&mutex_); return pollSchedule_.rules();}
+
+int Communication::getPollInterval(int omronID) const {
+  QMutexLocker locker(&mutex_);
+  const BusScheduler::Device *device = scheduler_.device(omronID);
+  return device ? device->interval : -1;
+}
+
+double Communication::getBusUtilization() const {
+  QMutexLocker locker(&mutex_);
+  const qint64 elapsed = busClock_.elapsed() - runStarted_;
+  if (!polling_ || elapsed <= 0) return 0.0;
+  return qMin(1.0, static_cast<double>(busBusy_) / elapsed);
+}
 
 /**
 @brief Overloaded operator== to compare two QSerialPortInfo objects
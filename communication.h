@@ -8,19 +8,52 @@
 #ifndef COMMUNICATION_H
 #define COMMUNICATION_H
 
-#include <QtSerialBus/QModbusRtuSerialMaster>
 #include <QSerialPort>
 #include <QStatusBar>
-#include <QModbusTcpClient>
 #include <QMutex>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <functional>
 #include "mainwindow.h"
+#include "busscheduler.h"
+#include "changefilter.h"
+#include "configsnapshot.h"
+#include "e5ccregisters.h"
+#include "framecapture.h"
+#include "modbusblock.h"
+#include "modbusgateway.h"
+#include "modbusqueue.h"
+#include "modbusstats.h"
+#include "modbustransport.h"
+#include "pollschedule.h"
+#include "portwatcher.h"
+#include "serialprobe.h"
+#include "writecoalescer.h"
 
+/**
+ * @brief The DeviceSample struct holds one status poll of a controller on the bus.
+ */
+struct DeviceSample
+{
+  int omronID{}; /**< Modbus slave address of the controller */
+  QDateTime timestamp; /**< Time at which the poll completed */
+  double temperature{}; /**< Present value */
+  double MV{}; /**< Output power */
+  double SV{}; /**< Set value */
+  double heaterCurrent{}; /**< Heater current 1 in A, measured while the output is on */
+  quint32 status{}; /**< Status double word, see E5ccRegisters::statusBit */
+  bool statusValid{false}; /**< false while the status word has never been read */
+  bool valid{true}; /**< false if one of the block reads of the poll failed */
+};
+Q_DECLARE_METATYPE(DeviceSample)
 
 class Communication : public QObject{
   Q_OBJECT
   Q_PROPERTY(double Temperature READ getTemperature WRITE setTemperature NOTIFY TemperatureUpdated)
   Q_PROPERTY(double SV READ getSV WRITE setSV NOTIFY SVUpdated)
   Q_PROPERTY(double MV READ getMV WRITE setMV NOTIFY MVUpdated)
+  Q_PROPERTY(double HeaterCurrent READ getHeaterCurrent NOTIFY HeaterCurrentUpdated)
   Q_PROPERTY(double MVupper READ getMVupper WRITE setMVupper NOTIFY MVupperUpdated)
   Q_PROPERTY(double MVlower READ getMVlower WRITE setMVlower NOTIFY MVlowerUpdated)
   Q_PROPERTY(int OmronID READ getOmronID WRITE setOmronID NOTIFY OmronIDChanged)
@@ -31,6 +64,10 @@ public:
 @brief Constructor for Communication class.
 @param parent The parent window that the Communication object belongs to.
 @param statusBar The status bar of the parent window.
+@details The object has no QObject parent. The owner moves it onto a dedicated QThread, so the
+Modbus transport and the poll timers never wait for the GUI thread. Public commands called from
+another thread are forwarded to the bus thread as queued calls, and the getters are guarded by
+a mutex.
 */
   Communication(QMainWindow *parent, QStatusBar *statusBar);
 
@@ -61,39 +98,36 @@ public:
       };
   };
 
+  /**
+   * @brief The Channel enum class names the polled values that pass a ChangeFilter before their
+   *        Updated signal is emitted.
+   */
+  enum class Channel {
+      Temperature, /**< TemperatureUpdated */
+      MV, /**< MVUpdated */
+      SV, /**< SVUpdated */
+      HeaterCurrent /**< HeaterCurrentUpdated */
+  };
+
   /**
 
   @brief Sends a Modbus request to the Omron device.
   @param code The function code to be sent.
   @param cmd The command to be sent.
-  This function sends a Modbus request to the Omron device. It first clears the status bar, sets the modbusReady_ flag to false, and creates a QModbusPdu object with the provided function code and data. It then creates a QModbusRequest object with the QModbusPdu, and sends it to the Omron device using the sendRawRequest() function. If successful, it connects a lambda function to the finished() signal of the QModbusReply object returned by the sendRawRequest() function. This lambda function checks for any errors in the reply and displays the appropriate message on the status bar. If the request was a broadcast, the reply is deleted immediately. Finally, the modbusReady_ flag is set to true.
-  @note This function assumes that the Omron device has already been connected to and configured through the QModbusTcpClient object omron_.
+  @param handler Optional handler called with the result of this request.
+  This function sends a Modbus request to the Omron device. It first clears the status bar and creates a QModbusRequest object with the provided function code and data. The request is queued on the ModbusQueue, which sends it as soon as the bus is free. When the reply of this very request arrives, errors are displayed on the status bar and the optional handler is called.
+  @note This function assumes that the Omron device has already been connected to and configured through the ModbusTransport object transport_.
   */
-  void request(QModbusPdu::FunctionCode code, QByteArray cmd);
+  void request(QModbusPdu::FunctionCode code, QByteArray cmd, ModbusQueue::Handler handler = ModbusQueue::Handler());
 
   /**
-   * @brief Formats an integer value to a hexadecimal string with the specified number of digits.
-   *
-   * This function takes an integer value and formats it as a hexadecimal string with the specified number of digits.
-   * If the resulting string is shorter than the specified width, leading zeroes are added to the beginning of the string.
-   *
-   * @param value The integer value to format.
-   * @param digit The number of digits for the resulting hexadecimal string.
-   * @return QString A QString object containing the formatted hexadecimal string.
-   */
-  QString formatHex(int value, int digit);
-
-  /**
-   * @brief Formats an E5CC register address as a hexadecimal string with the specified width.
-   *
-   * This function takes an E5CC register address as an enumeration type and formats it as a hexadecimal string with the specified width.
-   * If the resulting string is shorter than the specified width, leading zeroes are added to the beginning of the string.
-   *
-   * @param address The E5CC register address to format.
-   * @param width The width of the resulting hexadecimal string.
-   * @return QString A QString object containing the formatted hexadecimal string.
-   */
-  QString formatE5CCAddress(E5CC_Address::Type address, int width = 4);
+  @brief Sends a ready-made Modbus request to the Omron device.
+  @param ask The request PDU, e.g. built by E5ccRegisters.
+  @param handler Optional handler called with the result of this request.
+  @param lane The lane of the ModbusQueue. Operation commands and safety writes use the high lane.
+  */
+  void request(const QModbusRequest &ask, ModbusQueue::Handler handler = ModbusQueue::Handler(),
+               ModbusQueue::Lane lane = ModbusQueue::Lane::High);
 
   /**
   @brief Sends a request to get the temperature from the E5CC temperature controller.
@@ -126,6 +160,13 @@ public:
   */
   void askPID(QString PID);
 
+  /**
+  @brief Reads all registers of the E5CC temperature controller into the configuration snapshot.
+  @details The registers are fetched with a few block reads. The values of the first refresh and
+  all later changes are published with the Updated signals.
+  */
+  void askSetting();
+
   /**
   @brief Executes the connection to the ModBus device.
   */
@@ -156,12 +197,15 @@ public:
   /**
   @brief Changes the value of the output lower limit of the E5CC temperature controller.
   @param MVlower The new value of the output lower limit.
+  @details The write goes through the WriteCoalescer: while a write is on the bus, further
+  changes collapse to the latest value, which is sent as soon as the previous write completes.
   */
   void changeMVlowerValue(double MVlower);
 
   /**
   @brief Changes the value of the output upper limit of the E5CC temperature controller.
   @param MVupper The new value of the output upper limit.
+  @details The write goes through the WriteCoalescer, like changeMVlowerValue().
   */
   void changeMVupperValue(double MVupper);
 
@@ -169,34 +213,218 @@ public:
   @brief Changes the set value (SV) of the E5CC temperature controller.
   This function calculates the integer value to be sent to the temperature controller
   based on the given set value in degrees Celsius and the temperature decimal factor
-  of the temperature controller. It then creates a Modbus command with the calculated
-  value and sends it to the controller to change the SV.
+  of the temperature controller. It then hands the value to the WriteCoalescer, which
+  sends only the latest of several rapid changes.
   @param SV The set value to be set in degrees Celsius.
   */
   void changeSVValue(double SV);
 
   /**
-  @brief Sends a Modbus request with the specified function code and command data.
-  @param code The Modbus function code.
-  @param cmd The command data to be sent.
-  This method sends a Modbus request with the specified function code and command data
-  to the Omron device. The status bar message is cleared and the modbusReady_ flag is set to false
-  before the request is sent. If the request is successful, the reply is checked for errors.
-  If there is a protocol error, the error message and exception code are displayed in the status bar.
-  If there is another type of error, the error message and error code are displayed.
-  Once the reply has been handled, the modbusReady_ flag is set to true and the reply is deleted.
-  If the request fails, an error message is displayed in the status bar.
+  @brief Writes the same set value to several controllers at the same time.
+  @param omronIDs The Modbus slave addresses of the controllers.
+  @param SV The set value in degrees Celsius.
+  @details With broadcast writes enabled and a group covering every polled controller, one
+  broadcast request reaches all of them at once. It is sent through the WriteCoalescer, which
+  drops the values of the register still pending for the group first. Otherwise the writes are queued back to back in
+  one batch of the WriteCoalescer. Each controller reads the value back with its next poll and
+  reports the result with groupWriteVerified().
+  */
+  void sendGroupSV(const QList<int> &omronIDs, double SV);
+
+  /**
+  @brief Sends an operation command to several controllers at the same time.
+  @param omronIDs The Modbus slave addresses of the controllers.
+  @param command The run, stop or autotuning command.
+  @details The requests are sent like sendGroupSV(). The run and autotuning bits of the status
+  word are read back with the next poll of each controller.
+  */
+  void sendGroupCommand(const QList<int> &omronIDs, E5ccRegisters::Command command);
+
+  /**
+  @brief Enables or disables broadcast group writes.
+  @param enable true to send group writes to slave address 0 when the group covers every
+  polled controller. A broadcast reaches every device on the line, so it is off by default.
+  */
+  void setBroadcastWrites(bool enable);
+
+  /**
+  @brief Checks whether group writes may be broadcast.
+  @return true if broadcast writes are enabled.
+  */
+  bool isBroadcastWrites() const;
+
+  /**
+  @brief Enables or disables the group control of all polled controllers.
+  @param enable true to send Run(), Stop(), the autotuning of executeSendRequestAT() and the set
+  value of executeSendRequestSV() to every polled controller with sendGroupCommand() and
+  sendGroupSV(), false to send them to the controller selected with setOmronID() only. Off by
+  default.
+  */
+  void setGroupControl(bool enable);
+
+  /**
+  @brief Checks whether the commands of the main window go to all polled controllers.
+  @return true if group control is enabled.
+  */
+  bool isGroupControl() const;
+
+  /**
+  @brief Queues a read request for a block of registers.
+  @param type The register type to read.
+  @param adress The first register address.
+  @param size The number of registers to read.
+  @param handler Optional handler called with the result of this read. Without a handler the
+  reply is passed to readReady(), which decodes known variables and logs unknown ones.
+  @param lane The lane of the ModbusQueue. Reads on behalf of the user default to the low lane,
+  so they never hold up the status poll.
+  The request is queued on the ModbusQueue. The handler is bound to this request, so a late
+  reply can never be decoded as another register.
+  */
+  void read(QModbusDataUnit::RegisterType type, quint16 adress, int size, ModbusQueue::Handler handler = ModbusQueue::Handler(),
+            ModbusQueue::Lane lane = ModbusQueue::Lane::Low);
+
+  /**
+  @brief Adds a controller to the set of devices polled on the serial line.
+  @param omronID The Modbus slave address of the controller.
+  @param priority The relative share of the bus the controller gets when several devices are due.
+  @details Every device is polled with the update interval. Its status is published through
+  sampleUpdated(). The controller selected with setOmronID() is always polled while the
+  communication runs and additionally drives the TemperatureUpdated(), MVUpdated() and SVUpdated() signals.
+  */
+  void addPollDevice(int omronID, int priority = 1);
+
+  /**
+  @brief Removes a controller from the set of polled devices.
+  @param omronID The Modbus slave address of the controller.
+  */
+  void removePollDevice(int omronID);
+
+  /**
+  @brief Changes the share of the bus of a polled controller.
+  @param omronID The Modbus slave address of the controller.
+  @param priority The relative share of the bus.
+  */
+  void setPollPriority(int omronID, int priority);
+
+  /**
+  @brief Returns the slave addresses of the polled controllers.
+  @return The slave addresses in the order they were added.
+  */
+  QList<int> getPollDevices() const;
+
+  /**
+  @brief Returns the fraction of time the serial line was busy with status polls since Run().
+  @return The utilization between 0 and 1.
+  */
+  double getBusUtilization() const;
+
+  /**
+  @brief Enables or disables the adaptive poll interval.
+  @param enable true to derive the poll interval of each device from its process dynamics,
+  false to poll every device with the fixed update interval.
+  */
+  void setAdaptivePolling(bool enable);
+
+  /**
+  @brief Sets the bounds of the adaptive poll interval.
+  @param minInterval The shortest interval in milliseconds, used while the process needs attention.
+  @param maxInterval The longest interval in milliseconds, approached while the process is steady.
+  */
+  void setIntervalUpdateBounds(int minInterval, int maxInterval);
+
+  /**
+  @brief Sets the temperature limit near which the status is polled faster.
+  @param limit The permitted maximum temperature.
+  */
+  void setSafetyLimit(double limit);
+
+  /**
+  @brief Sets how often a register is read by the status poll.
+  @param address The register address of the variable.
+  @param period The time in milliseconds between two reads, 0 to read it with every poll of the device.
+  @param priority The order in which due registers are packed into the block reads of a poll, higher first.
+  */
+  void setRegisterPoll(quint16 address, int period, int priority = 1);
+
+  /**
+  @brief Returns the poll rules of the registers.
+  @return The rules, sorted by descending priority.
+  */
+  QVector<PollSchedule::Rule> getRegisterPolls() const;
+
+  /**
+  @brief Applies the poll settings stored in QSettings and stores the ones in effect.
+  @details The group "poll" holds "adaptive", "minInterval" and "maxInterval" and the array
+  "poll/registers" of address, period and priority. A stored rule replaces the built-in rule of
+  its register. The change filters are read from "filter/<channel>" for the Updated signals and
+  from "sample/<channel>" for sampleUpdated(), each with "absolute", "relative" and "heartbeat";
+  the channels are "temperature", "mv", "sv" and "heaterCurrent". Since the effective settings
+  are written back, every key can be edited in the settings file after the first start.
+  */
+  void loadPollSettings();
+
+  /**
+  @brief Configures the change filter of a polled value.
+  @param channel The value.
+  @param absolute The absolute deadband in engineering units.
+  @param relative The deadband as a fraction of the last published value.
+  @param heartbeat The longest time in milliseconds without an Updated signal, 0 for none.
+  @details A poll emits the Updated signal of the value only if it has moved by more than the
+  deadband or the heartbeat has elapsed. The deadband is 0 by default, so the data file and the
+  safety checks fed by these signals see every change.
+  */
+  void setChangeFilter(Channel channel, double absolute, double relative, int heartbeat = ChangeFilter::heartbeatDefault);
+
+  /**
+  @brief Configures the change filter of a polled value for sampleUpdated().
+  @param channel The value.
+  @param absolute The absolute deadband in engineering units.
+  @param relative The deadband as a fraction of the last published value.
+  @param heartbeat The longest time in milliseconds without a sampleUpdated() signal, 0 for none.
+  @details sampleUpdated() is emitted if any value of the device passes its filter. The
+  temperature, MV and heater current drop changes of one digit by default, the set value passes
+  every change.
+  */
+  void setSampleFilter(Channel channel, double absolute, double relative, int heartbeat = ChangeFilter::heartbeatDefault);
+
+  /**
+  @brief Checks whether the adaptive poll interval is enabled.
+  @return true if the poll interval adapts to the process dynamics.
+  */
+  bool isAdaptivePolling() const;
+
+  /**
+  @brief Returns the current poll interval of a controller.
+  @param omronID The Modbus slave address of the controller.
+  @return The interval in milliseconds, or -1 if the controller is not polled.
   */
-  void read(QModbusDataUnit::RegisterType type, quint16 adress, int size);
+  int getPollInterval(int omronID) const;
 
   /**
   @brief Sets the name of the serial port to use for Modbus communication
-  @param portName The name of the serial port to use
+  @param portName The name of the serial port to use, or "tcp://host:port" to reach the
+  controllers through a Modbus TCP gateway.
   */
   void setSerialPortName(QString portName);
 
   /**
-  @brief Checks if the update timer is currently running.
+  @brief Sets the serial parameters of the next connection. Data bits are always 8 for Modbus RTU.
+  @param baudRate The baud rate, e.g. QSerialPort::Baud38400.
+  @param parity The parity, a QSerialPort::Parity.
+  @param stopBits The stop bits, a QSerialPort::StopBits.
+  @details With auto-probe these settings are tried first.
+  */
+  void setSerialSettings(int baudRate, int parity, int stopBits);
+
+  /**
+  @brief Enables or disables the detection of the serial settings when connecting.
+  @param enable true to try candidate settings, fastest first, and lock onto the first one
+  the controller answers at. The result is reported with serialSettingsDetected().
+  */
+  void setAutoProbe(bool enable);
+
+  /**
+  @brief Checks if the status is polled periodically.
   @return true if the update timer is running, false otherwise.
   */
   bool isTimerUpdateRunning() const;
@@ -250,10 +478,78 @@ public:
   void setIntervalConectionCheck(int interval);
 
   /**
-  @brief Returns a pointer to the QModbusRtuSerialMaster object used for communication with the Omron PLC.
-  @return A pointer to the QModbusRtuSerialMaster object
+  @brief Returns a pointer to the ModbusTransport object used for communication with the Omron controllers.
+  @return A pointer to the ModbusTransport object
   **/
-  QModbusRtuSerialMaster* getOmron() const;
+  ModbusTransport* getTransport() const;
+
+  /**
+  @brief Returns the latency and error statistics of the Modbus transactions.
+  @return A pointer to the statistics. They may be read from any thread.
+  **/
+  ModbusStats* getStats();
+
+  /**
+  @brief Starts writing every Modbus transaction to a capture file.
+  @param fileName The capture file. It can be replayed by connecting to "replay:" followed by its path.
+  @return false if the file cannot be written.
+  */
+  bool startCapture(const QString &fileName);
+
+  /**
+  @brief Stops writing the capture file.
+  */
+  void stopCapture();
+
+  /**
+  @brief Checks whether the transactions are written to a capture file.
+  @return true while capturing.
+  */
+  bool isCapturing() const;
+
+  /**
+  @brief Returns how often the connection has recovered since the start.
+  @return The number of recoveries.
+  */
+  int getRecoveryCount() const;
+
+  /**
+  @brief Returns the recovery time of the last reconnect.
+  @return The time in milliseconds from the loss of the link until the state was verified, 0 before the first recovery.
+  */
+  qint64 getLastRecoveryTime() const;
+
+  /**
+   * @brief Returns the last published status word of a controller.
+   * @param omronID The Modbus slave address of the controller.
+   * @return The status double word, see E5ccRegisters::statusBit, or 0 if it has not been polled.
+   */
+  quint32 getDeviceStatus(int omronID) const;
+
+  /**
+   * @brief Opens or closes the local Modbus TCP gateway, see ModbusGateway.
+   * @param port The TCP port on the local host, 0 to close the gateway.
+   * @details The result is reported with gatewayChanged().
+   */
+  void setGateway(int port);
+
+  /**
+   * @brief Sets the age up to which the gateway answers reads from the register cache.
+   * @param maxAge The age in milliseconds, 0 to send every read of a client to the bus.
+   */
+  void setGatewayMaxAge(int maxAge);
+
+  /**
+   * @brief Gets the port of the local Modbus TCP gateway.
+   * @return The port, 0 while the gateway is closed.
+   */
+  int getGatewayPort() const;
+
+  /**
+  @brief Returns the cached image of the registers of the E5CC temperature controllers.
+  @return A pointer to the snapshot. Its entries may be read from any thread.
+  **/
+  ConfigSnapshot* getSnapshot() const;
 
   /**
   @brief Returns a list of QSerialPortInfo objects containing information about available serial port devices.
@@ -267,6 +563,11 @@ public:
   */
   QString getPortName() const;
 
+  int getBaudRate() const;
+  int getParity() const;
+  int getStopBits() const;
+  bool isAutoProbe() const;
+
   /**
    * @brief Gets the current temperature value.
    * @return The current temperature value
@@ -279,6 +580,12 @@ public:
    */
   double getMV() const;
 
+  /**
+   * @brief Gets the heater current.
+   * @return The heater current 1 in A
+   */
+  double getHeaterCurrent() const;
+
   /**
    * @brief Gets the current output power value.
    * @return The current output power value
@@ -344,7 +651,7 @@ public:
   getTempTimer = 500, /**< The time in milliseconds between requests for temperature */
   clockUpdate = 50, /**< The time in milliseconds between clock updates */
   timeUp = 1000 * 60 * 10, /**< The maximum time in milliseconds before resetting the clock */
-  timeOut = 700 /**< The time in milliseconds before a Modbus communication times out */
+  timeOut = 700 /**< The response timeout in milliseconds until round trips of the device have been measured */
   };
 
 signals:
@@ -360,6 +667,20 @@ signals:
   */
   void MVUpdated(double MV);
 
+  /**
+  @brief This signal is emitted when the heater current value is updated.
+  @param current The new heater current in A.
+  */
+  void HeaterCurrentUpdated(double current);
+
+  /**
+  @brief This signal is emitted with every valid poll of the selected controller, unfiltered, so
+  a detector can correlate the output with the current that flows.
+  @param MV The output power.
+  @param current The heater current in A.
+  */
+  void heaterSampled(double MV, double current);
+
   /**
   @brief This signal is emitted when the set value is updated.
   @param SV The new set value.
@@ -403,8 +724,8 @@ signals:
   void ATSendFinish(int atFlag);
 
   /**
-   * @brief Emitted when a set value (SV) command is sent to the Omron device and the send is finished.
-   * @param SV The updated SV value.
+   * @brief Emitted when a set value (SV) has been written to the Omron device and read back.
+   * @param SV The SV read back from the device.
    */
   void SVSendFinish(double SV);
 
@@ -435,6 +756,16 @@ signals:
    */
   void failedConnect();
 
+  /**
+   * @brief Emitted when auto-probe has found the serial settings of the controller.
+   * @param portName The serial port.
+   * @param omronID The Modbus slave address of the controller.
+   * @param baudRate The baud rate.
+   * @param parity The parity, a QSerialPort::Parity.
+   * @param stopBits The stop bits, a QSerialPort::StopBits.
+   */
+  void serialSettingsDetected(const QString &portName, int omronID, int baudRate, int parity, int stopBits);
+
   /**
    * @brief Emitted when the Omron device ID is changed.
    */
@@ -446,6 +777,12 @@ signals:
    */
   void serialPortRemove(QString str);
 
+  /**
+   * @brief Emitted when a lost connection is back and the state of the controllers has been verified.
+   * @param recoveryTime The time in milliseconds since the link was lost.
+   */
+  void connectionRecovered(qint64 recoveryTime);
+
   /**
    * @brief Emitted when the interval for updating values is changed.
    * @param interval The new interval in milliseconds.
@@ -458,27 +795,145 @@ signals:
    */
   void intervalConectionCheckChanged(int interval);
 
+  /**
+   * @brief Emitted when a message should be shown in the status bar.
+   * @param message The message. An empty message clears the status bar.
+   * @param timeout The time in milliseconds the message is shown. 0 keeps it until the next message.
+   */
+  void statusMessage(const QString &message, int timeout = 0);
+
+  /**
+   * @brief Emitted when a value polled from a controller on the bus has moved past its sample filter.
+   * @param sample The values read from the controller.
+   */
+  void sampleUpdated(const DeviceSample &sample);
+
+  /**
+   * @brief Emitted when the adaptive poll interval of a controller changes.
+   * @param omronID The Modbus slave address of the controller.
+   * @param interval The new interval in milliseconds.
+   */
+  void pollIntervalChanged(int omronID, int interval);
+
+  /**
+   * @brief Emitted when the polled status word of a controller changes.
+   * @param omronID The Modbus slave address of the controller.
+   * @param status The status double word, see E5ccRegisters::statusBit.
+   * @param changed The bits that differ from the last poll, all bits for the first poll.
+   */
+  void deviceStatusChanged(int omronID, quint32 status, quint32 changed);
+
+  /**
+   * @brief Emitted when the run state of the selected controller changes on the device.
+   * @param running true if the controller is running.
+   */
+  void runStateChanged(bool running);
+
+  /**
+   * @brief Emitted when the autotuning of the selected controller starts or ends on the device.
+   * @param running true while the autotuning is executed.
+   */
+  void autotuningChanged(bool running);
+
+  /**
+   * @brief Emitted when the alarm outputs, heater burnout or input error of the selected controller change.
+   * @param status The status double word, see E5ccRegisters::statusBit.
+   */
+  void alarmStateChanged(quint32 status);
+
+  /**
+   * @brief Emitted when the local Modbus TCP gateway has been opened or closed.
+   * @param port The port the gateway listens on, 0 if it is closed or could not be opened.
+   */
+  void gatewayChanged(int port);
+
+  /**
+   * @brief Emitted when the read-back of a group write is done.
+   * @param omronID The Modbus slave address of the controller.
+   * @param address The register address that was checked, SV or the status word.
+   * @param ok true if the controller holds the written value.
+   */
+  void groupWriteVerified(int omronID, quint16 address, bool ok);
+
 private:
+  /**
+   * @brief The Expectation struct holds the value a controller must show after a group write.
+   */
+  struct Expectation {
+    quint32 mask; /**< Bits of the double word that are compared */
+    quint32 value; /**< Expected value of the compared bits */
+    int checks; /**< Read-backs left before the write counts as failed */
+  };
+
+  /**
+  @brief Handler of writeAndVerify(), called with the outcome, the value read back and the reason of a failure.
+  */
+  using VerifyHandler = std::function<void(bool ok, double value, const QString &message)>;
+
+  /**
+   * @brief The Verification struct holds a write whose read-back is awaited.
+   */
+  struct Verification {
+    qint32 raw{}; /**< Raw value written */
+    VerifyHandler done; /**< Handler called with the result of the read-back */
+  };
+
   QMainWindow* mainwindow_{nullptr}; /**< Pointer to the main window */
   QStatusBar* statusBar_{nullptr}; /**< Pointer to the status bar */
-  QModbusRtuSerialMaster* omron_{nullptr}; /**< Pointer to the Omron device */
+  ModbusTransport* transport_{nullptr}; /**< RTU or TCP transport to the Omron devices */
   QList<QSerialPortInfo> infos_; /**< List of serial port information */
-  QModbusTcpClient* modbusDevice_{nullptr}; /**< Pointer to the Modbus device */
-  QModbusReply* modbusReply_{nullptr}; /**< Pointer to the Modbus reply */
+  ModbusQueue* queue_{nullptr}; /**< Request pipeline of the Modbus transactions */
+  ModbusStats stats_; /**< Latency and error statistics of the Modbus transactions */
+  FrameCapture capture_; /**< Capture file of the Modbus transactions */
+  QHash<quint32, qint32> commanded_; /**< Last commanded raw value per controller and register, keyed like the read-backs */
+  QHash<int, bool> commandedRun_; /**< Last commanded run state per controller, true for run */
+  QHash<int, qint64> stateCommanded_; /**< Bus clock time of the last run, stop or AT command per controller */
+  QHash<int, quint32> lastStatus_; /**< Last published status word per controller */
+  qint64 lostAt_{-1}; /**< Bus clock time at which the link was lost, -1 while it is up */
+  int recoveries_{0}; /**< Number of recoveries of the link */
+  qint64 lastRecovery_{0}; /**< Recovery time of the last reconnect in milliseconds */
+  WriteCoalescer* writer_{nullptr}; /**< Latest-value-wins writer of set values and limits */
+  ConfigSnapshot* snapshot_{nullptr}; /**< Cached image of all registers, refreshed in the background */
+  SerialProbe* probe_{nullptr}; /**< Detection of the serial settings of the controller */
+  ModbusGateway* gateway_{nullptr}; /**< Local Modbus TCP server sharing the line with other programs */
+  int gatewayPort_{0}; /**< Port of the gateway, 0 while it is closed */
+  ChangeFilter filters_[4]; /**< Change filters of the Updated signals, indexed by Channel */
+  ChangeFilter sampleFilters_[4]; /**< Change filters of sampleUpdated(), indexed by Channel */
+  BusScheduler scheduler_; /**< Decides which controller on the line is polled next */
+  PollSchedule pollSchedule_; /**< Decides which registers a poll of a controller reads */
+  QElapsedTimer busClock_; /**< Monotonic clock of the poll schedule */
   QTimer* timerUpdate_{nullptr}; /**< Pointer to the timer used for updating data */
-  QTimer* connectTimer_{nullptr}; /**< Pointer to the timer used for connection check */
-  QMutex mutex_; /**< Mutex for thread safety */
+  PortWatcher* portWatcher_{nullptr}; /**< Watcher of serial adapters being plugged in and out */
+  mutable QMutex mutex_; /**< Mutex guarding the values shared with the GUI thread */
   QString portName_; /**< Name of the serial port */
-  QSerialPort* serialPort_{nullptr}; /**< Pointer to the serial port */
-  int respondType_{}; /**< Type of response */
+  int baudRate_{QSerialPort::Baud9600}; /**< Baud rate of the serial port */
+  int parity_{QSerialPort::NoParity}; /**< Parity of the serial port */
+  int stopBits_{QSerialPort::TwoStop}; /**< Stop bits of the serial port */
+  bool autoProbe_{false}; /**< Flag indicating if the serial settings are detected when connecting */
   int omronID_{}; /**< Omron device ID */
   int intervalUpdate_{3000}; /**< Interval for updating data */
-  int intervalConectionCheck_{10000}; /**< Interval for connection check */
-  bool modbusReady_{false}; /**< Flag indicating if Modbus is ready */
+  int intervalConectionCheck_{10000}; /**< Interval for connection check where no device events are available */
+  int minIntervalUpdate_{500}; /**< Shortest adaptive poll interval */
+  int maxIntervalUpdate_{15000}; /**< Longest adaptive poll interval */
+  bool adaptivePolling_{true}; /**< Flag indicating if the poll interval adapts to the process dynamics */
+  bool broadcastWrites_{false}; /**< Flag indicating if group writes may use slave address 0 */
+  bool groupControl_{false}; /**< Flag indicating if run, stop and SV go to all polled controllers */
+  QHash<quint32, Verification> verifications_; /**< Pending writeAndVerify() calls, keyed by slave address and register */
+  QHash<quint32, Expectation> expectations_; /**< Pending read-backs of group writes, keyed by slave address and register */
+  QHash<int, double> groupSV_; /**< Set values of sendRequestSV() waiting for the group read-back, keyed by slave address */
+  double safetyLimit_{280.0}; /**< Permitted maximum temperature used to speed up polling */
+  QHash<int, DeviceSample> lastSamples_; /**< Last valid sample of each polled controller */
+  QHash<int, double> slopes_; /**< Smoothed |dT/dt| of each polled controller in kelvin per minute */
+  int statusPending_{0}; /**< Number of block reads of the running status cycle */
+  qint64 pollStarted_{0}; /**< Time at which the running status cycle started */
+  qint64 runStarted_{0}; /**< Time at which the polling was started */
+  qint64 busBusy_{0}; /**< Time in milliseconds spent in status cycles since the polling was started */
   bool isSerialPortRemoved_{false}; /**< Flag indicating if the serial port is removed */
+  bool polling_{false}; /**< Flag indicating if the status is polled periodically */
   double temperature_{}; /**< Temperature value */
   double SV_{}; /**< Set value */
   double MV_{}; /**< Measured value */
+  double heaterCurrent_{}; /**< Heater current 1 in A */
   double MVupper_{}; /**< Upper limit of the measured value */
   double MVlower_{}; /**< Lower limit of the measured value */
   double tempDecimal_{0.1}; /**< Decimal point of the temperature value */
@@ -487,15 +942,21 @@ private:
   double pid_D_{}; /**< Derivative term of the PID controller */
 
   /**
-  @brief Establishes the connection to the serial port and the Omron PLC device
-  Initializes the QModbusRtuSerialMaster object and sets its connection parameters
-  (serial port name, baud rate, data bits, parity, and stop bits), timeout, and number
-  of retries. Then, attempts to connect to the device and emits the corresponding signals
-  based on the outcome. If the connection is successful, sends a request to write a
-  single register with the command "00 00 01 01" in hexadecimal format.
+  @brief Establishes the connection to the serial port or gateway and the Omron PLC device
+  Configures the ModbusTransport from the port name: RTU with the serial settings on a serial
+  port, by default 9600 8N2, or TCP for a "tcp://host:port" endpoint, together with the timeout
+  and number of retries. With auto-probe the serial settings are detected first.
   */
   void Connection();
 
+  /**
+  @brief Opens the transport and emits the corresponding signals based on the outcome.
+  If the connection is successful, sends a request to write a single register with the
+  command "00 00 01 01" in hexadecimal format.
+  @param settings The connection parameters.
+  */
+  void open(const ModbusTransport::Settings &settings);
+
   /**
   @brief Starts the communication with the Omron E5CC controller and sets up timers for periodic updates and connection checking.
   */
@@ -510,33 +971,187 @@ private:
   */
   void sendRequestAT(int afFlag);
 
-private slots:
   /**
-   * @brief Pauses the execution for a specified amount of time.
-   * @param msec The time to pause in milliseconds.
-   */
-  void waitForMsec(int msec);
+  @brief Handles the result of a read request.
+  @details If the result contains an error, it shows an error message in the status bar.
+  Otherwise, every known variable covered by the reply is decoded and stored in the appropriate
+  member variable. Replies that contain no known variable are written to the log.
+  @param result The result of the read request.
+  @return true if the read succeeded, false otherwise.
+  */
+  bool readReady(const ModbusResult &result);
+
+  /**
+  @brief Decodes every known E5CC variable contained in a block of registers.
+  @param start The address of the first register.
+  @param values The register values returned by the device.
+  @return true if at least one known variable was decoded, false otherwise.
+  */
+  bool decodeRegisters(quint16 start, const QVector<quint16> &values);
+
+  /**
+  @brief Shows the error of a failed read in the status bar.
+  @param result The result of the read request.
+  @return true if the read succeeded, false otherwise.
+  */
+  bool checkRead(const ModbusResult &result);
+
+  /**
+  @brief Queues a read request for a block of registers of a given controller.
+  @param omronID The Modbus slave address of the controller.
+  @param code The read function code.
+  @param address The first register address.
+  @param size The number of registers to read.
+  @param handler The handler called with the result of this read.
+  @param lane The lane of the ModbusQueue.
+  */
+  void readDevice(int omronID, QModbusPdu::FunctionCode code, quint16 address, int size, ModbusQueue::Handler handler,
+                  ModbusQueue::Lane lane = ModbusQueue::Lane::High);
+
+  /**
+  @brief Reads PV, MV and SV of a controller with as few block reads as possible.
+  @param omronID The Modbus slave address of the controller.
+  */
+  void pollDevice(int omronID);
+
+  /**
+  @brief Publishes a completed status poll and schedules the next one.
+  @param sample The values read from the controller.
+  */
+  void finishPoll(const DeviceSample &sample);
+
+  /**
+  @brief Arms the update timer for the device that becomes due next.
+  */
+  void schedulePoll();
+
+  /**
+  @brief Updates the smoothed temperature slope of a controller with a new sample.
+  @param sample The latest valid sample.
+  @return The smoothed slope |dT/dt| in kelvin per minute, or a negative value if it is not known yet.
+  */
+  double updateSlope(const DeviceSample &sample);
 
   /**
-  @brief Slot that is called when a read request to the modbus device is ready.
-  @details This function handles the response to a read request to the modbus device.
-  If the response contains an error, it shows an error message in the status bar.
-  Otherwise, it parses the response and stores the data in the appropriate member variable,
-  based on the type of response (PV, SV, MV, etc.).
-  @note This function assumes that the read request is a response to a previous read request
-  that was sent by the Communication class.
+  @brief Derives the poll interval of a controller from its process dynamics.
+  @param sample The latest valid sample.
+  @param slope The smoothed slope |dT/dt| in kelvin per minute.
+  @param current The interval the controller is polled with now.
+  @return The new interval in milliseconds, within the configured bounds.
+  @note The caller holds mutex_.
   */
-  void readReady();
+  int adaptInterval(const DeviceSample &sample, double slope, int current) const;
 
+  /**
+  @brief Publishes a value read by the configuration snapshot.
+  @param omronID The address of the controller.
+  @param address The register address of the variable.
+  @param value The new engineering value.
+  @param first true if the variable was read for the first time.
+  */
+  void applySetting(int omronID, quint16 address, double value, bool first);
+
+  /**
+  @brief Checks whether a group write can be sent as one broadcast.
+  @param omronIDs The Modbus slave addresses of the group.
+  @return true if broadcast writes are enabled and the group covers every polled controller.
+  */
+  bool isBroadcastGroup(const QList<int> &omronIDs) const;
+
+  /**
+  @brief Registers the read-back of a group write and schedules it.
+  @param omronID The Modbus slave address of the controller.
+  @param address The register address to read back.
+  @param mask The bits of the double word that are compared.
+  @param value The expected value of the compared bits.
+  */
+  void expect(int omronID, quint16 address, quint32 mask, quint32 value);
+
+  /**
+  @brief Writes a variable and reads it back without waiting for a poll.
+  @param omronID The Modbus slave address of the controller.
+  @param address The register address of the variable.
+  @param value The engineering value.
+  @param done The handler called with the result of the read-back.
+  */
+  void writeAndVerify(int omronID, quint16 address, double value, VerifyHandler done);
+
+  /**
+  @brief Completes the writeAndVerify() calls whose registers a read-back covers.
+  @param omronID The Modbus slave address of the controller.
+  @param start The first register address read.
+  @param values The register values read.
+  */
+  void finishVerifications(int omronID, quint16 start, const QVector<quint16> &values);
+
+  /**
+  @brief Reads a register back with the next poll, or at once if the controller is not polled.
+  @param omronID The Modbus slave address of the controller.
+  @param address The register address to read back.
+  @param delay The time in milliseconds to wait before a direct read.
+  */
+  void requestReadBack(int omronID, quint16 address, int delay = 0);
+
+  /**
+  @brief Compares the pending read-backs of a controller with a block reply.
+  @param omronID The Modbus slave address of the controller.
+  @param start The first register address of the reply.
+  @param values The register values of the reply.
+  */
+  void verifyReadBack(int omronID, quint16 start, const QVector<quint16> &values);
+
+  /**
+  @brief Forwards a task to the bus thread if it is called from another thread.
+  @param task The task to run in the thread the Communication object lives in.
+  @return true if the task was posted and the caller has to return, false if the caller
+  already runs in the bus thread.
+  */
+  bool postToBusThread(std::function<void()> task);
+
+private slots:
   /**
    * @brief Sends a request for the status of the Omron device.
+   * @details PV, MV and SV are fetched with as few block reads as possible.
    */
   void askStatus();
 
   /**
-   * @brief Checks the connection to the Omron device and attempts to reconnect if necessary.
+   * @brief Polls the next due controller on the line.
+   */
+  void pollNext();
+
+  /**
+   * @brief Reports the loss of the serial adapter in use with serialPortRemove().
+   * @param portName The name of the port that has disappeared.
+   */
+  void serialPortRemoved(const QString &portName);
+
+  /**
+   * @brief Adds a serial port that has appeared to the list of devices and reconnects at once if it is the port in use.
+   * @param portName The name of the port.
+   */
+  void serialPortAdded(const QString &portName);
+
+  /**
+   * @brief Verifies the state of the controllers after a lost connection is back.
+   */
+  void resynchronize();
+
+  /**
+   * @brief Writes again the commanded values and run state that differ in a block read after a reconnect.
+   * @param omronID The Modbus slave address of the controller.
+   * @param start The first register address of the block.
+   * @param values The register values of the block.
+   */
+  void restoreCommanded(int omronID, quint16 start, const QVector<quint16> &values);
+
+  /**
+   * @brief Takes a write of a gateway client into the register cache and the commanded values.
+   * @param omronID The Modbus slave address of the controller.
+   * @param start The first register address written.
+   * @param values The register values written.
    */
-  void checkConnection();
+  void applyGatewayWrite(int omronID, quint16 start, const QVector<quint16> &values);
 };
 #endif // COMMUNICATION_H
 
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include "configsnapshot.h"
+#include "e5ccregisters.h"
+
+ConfigSnapshot::ConfigSnapshot(ModbusQueue *queue, QObject *parent)
+  : QObject(parent),
+    queue_(queue)
+{
+  QVector<quint16> addresses;
+  for (const E5ccRegister &reg : E5ccRegisters::table) addresses.append(reg.address);
+  plan_ = ModbusBlock::plan(addresses);
+  refreshTimer_ = new QTimer(this);
+  connect(refreshTimer_, &QTimer::timeout, this, &ConfigSnapshot::refreshAll);
+}
+
+void ConfigSnapshot::refresh(int serverAddress){
+  if (passes_.contains(serverAddress)) return;
+  devices_.insert(serverAddress);
+  const QVector<ModbusBlock> blocks = plan(serverAddress);
+  if (blocks.isEmpty()) return;
+  Pass &pass = passes_[serverAddress];
+  pass.pending = blocks.size();
+  for (const ModbusBlock &block : blocks) readBlock(serverAddress, block);
+}
+
+void ConfigSnapshot::refreshAll(){
+  for (const int serverAddress : qAsConst(devices_)) refresh(serverAddress);
+}
+
+void ConfigSnapshot::readBlock(int serverAddress, const ModbusBlock &block){
+  const QModbusRequest request = E5ccRegisters::readRequest(block.start, block.count);
+  queue_->enqueue(request, serverAddress, [this, serverAddress, block](const ModbusResult &result) {
+    Pass &pass = passes_[serverAddress];
+    if (result.isValid()) {
+      pass.changes += store(serverAddress, result.startAddress(), result.values());
+    } else if (result.error == QModbusDevice::ProtocolError
+               && result.response.exceptionCode() == QModbusPdu::IllegalDataAddress) {
+      const QVector<ModbusBlock> parts = split(serverAddress, block);
+      pass.pending += parts.size();
+      for (const ModbusBlock &part : parts) readBlock(serverAddress, part);
+    } else {
+      pass.errors++;
+    }
+    finishBlock(serverAddress);
+  }, ModbusQueue::Lane::Low);
+}
+
+void ConfigSnapshot::finishBlock(int serverAddress){
+  Pass &pass = passes_[serverAddress];
+  if (--pass.pending > 0) return;
+  const Pass done = pass;
+  passes_.remove(serverAddress);
+  emit refreshed(serverAddress, done.changes, done.errors);
+}
+
+/**
+ * @details A variable is reported when its raw value differs from the cached one. Only the
+ * timestamp of the last read is updated for an unchanged variable.
+ */
+int ConfigSnapshot::store(int serverAddress, quint16 start, const QVector<quint16> &values){
+  struct Change {quint16 address; double value; bool first;};
+  QVector<Change> changes;
+  const QDateTime now = QDateTime::currentDateTime();
+  mutex_.lock();
+  for (const E5ccRegister &reg : E5ccRegisters::table) {
+    const int offset = reg.address - start;
+    if (offset < 0 || offset + reg.width > values.size() || unsupported_.contains(key(serverAddress, reg.address))) continue;
+    quint32 raw = 0;
+    for (int i = 0; i < reg.width; i++) raw = (raw << 16) | values.at(offset + i);
+    Entry &entry = cache_[key(serverAddress, reg.address)];
+    const bool first = !entry.valid;
+    entry.read = now;
+    if (!first && entry.raw == static_cast<qint32>(raw)) continue;
+    entry.raw = static_cast<qint32>(raw);
+    entry.value = reg.decode(raw, tempDecimal_);
+    entry.changed = now;
+    entry.valid = true;
+    changes.append({reg.address, entry.value, first});
+  }
+  mutex_.unlock();
+  for (const Change &change : qAsConst(changes)) {
+    emit valueChanged(serverAddress, change.address, change.value, change.first);
+  }
+  return changes.size();
+}
+
+/**
+ * @details The block is cut at the largest gap between two of its variables, or in the middle if
+ * the variables are packed. A single refused variable is dropped from the plan. Devices of
+ * different models or options refuse different variables, so each device splits its own copy
+ * of the plan.
+ */
+QVector<ModbusBlock> ConfigSnapshot::split(int serverAddress, const ModbusBlock &block){
+  QVector<quint16> addresses;
+  QMutexLocker locker(&mutex_);
+  for (const E5ccRegister &reg : E5ccRegisters::table) {
+    if (block.contains(reg.address) && !unsupported_.contains(key(serverAddress, reg.address))) addresses.append(reg.address);
+  }
+  std::sort(addresses.begin(), addresses.end());
+  QVector<ModbusBlock> parts;
+  if (addresses.size() <= 1) {
+    for (const quint16 address : qAsConst(addresses)) unsupported_.insert(key(serverAddress, address));
+  } else {
+    int cut = addresses.size() / 2;
+    int widest = 0;
+    for (int i = 1; i < addresses.size(); i++) {
+      const int gap = addresses.at(i) - addresses.at(i - 1) - E5ccRegisters::at(addresses.at(i - 1)).width;
+      if (gap > widest) {
+        widest = gap;
+        cut = i;
+      }
+    }
+    for (const QVector<quint16> &half : {addresses.mid(0, cut), addresses.mid(cut)}) {
+      ModbusBlock part;
+      part.start = half.first();
+      part.count = static_cast<quint16>(half.last() + E5ccRegisters::at(half.last()).width - part.start);
+      parts.append(part);
+    }
+  }
+  if (!plans_.contains(serverAddress)) plans_.insert(serverAddress, plan_);
+  QVector<ModbusBlock> &plan = plans_[serverAddress];
+  for (int i = 0; i < plan.size(); i++) {
+    if (plan.at(i).start != block.start || plan.at(i).count != block.count) continue;
+    plan.remove(i);
+    for (int j = 0; j < parts.size(); j++) plan.insert(i + j, parts.at(j));
+    break;
+  }
+  return parts;
+}
+
+void ConfigSnapshot::update(int serverAddress, quint16 start, const QVector<quint16> &values){
+  store(serverAddress, start, values);
+}
+
+void ConfigSnapshot::setRefreshInterval(int interval){
+  if (interval <= 0) {
+    refreshTimer_->stop();
+    return;
+  }
+  refreshTimer_->start(interval);
+}
+
+void ConfigSnapshot::clear(){
+  QMutexLocker locker(&mutex_);
+  cache_.clear();
+}
+
+ConfigSnapshot::Entry ConfigSnapshot::entry(int serverAddress, quint16 address) const {
+  QMutexLocker locker(&mutex_);
+  return cache_.value(key(serverAddress, address));
+}
+
+quint32 ConfigSnapshot::key(int serverAddress, quint16 address){
+  return (static_cast<quint32>(serverAddress & 0xFFFF) << 16) | address;
+}
+
+void ConfigSnapshot::setTempDecimal(double tempDecimal){QMutexLocker locker(&mutex_); tempDecimal_ = tempDecimal;}
+QVector<ModbusBlock> ConfigSnapshot::plan(int serverAddress) const {QMutexLocker locker(&mutex_); return plans_.value(serverAddress, plan_);}
+bool ConfigSnapshot::isRefreshing(int serverAddress) const {return passes_.contains(serverAddress);}
@@ -0,0 +1,183 @@
+/**
+ * @file configsnapshot.h
+ * @brief Declaration of the ConfigSnapshot class, a cached image of all E5CC registers.
+ */
+
+#ifndef CONFIGSNAPSHOT_H
+#define CONFIGSNAPSHOT_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QTimer>
+#include "modbusblock.h"
+#include "modbusqueue.h"
+
+/**
+ * @brief The ConfigSnapshot class reads every register of the E5ccRegisters table in as few
+ * block reads as possible and keeps the values with their timestamps.
+ *
+ * The registers are grouped by ModbusBlock::plan(). A block the device refuses with exception
+ * 02 (illegal data address) is split at its largest gap and the parts are read again, until a
+ * single variable is left, which is then skipped from then on. The learned plan is kept, so later
+ * refreshes cost the same number of requests as the first one.
+ *
+ * The first refresh of a device reports every variable through valueChanged(). Later refreshes
+ * report only the variables whose raw value differs from the cache, so a background refresh
+ * detects configuration drift without disturbing anything that did not change.
+ */
+class ConfigSnapshot : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * @brief The Entry struct holds the cached value of one variable.
+   */
+  struct Entry
+  {
+    double value{}; /**< Engineering value */
+    qint32 raw{}; /**< Raw value as read from the registers */
+    QDateTime read; /**< Time of the last successful read */
+    QDateTime changed; /**< Time the value was first read or last changed */
+    bool valid{false}; /**< Flag indicating if the variable has been read */
+  };
+
+  /**
+   * @brief The timing enumeration defines the default refresh interval.
+   */
+  enum timing {
+    refreshDefault = 60000 /**< Background refresh in ms */
+  };
+
+  /**
+   * @brief Constructs a snapshot reading through a queue.
+   * @param queue The queue the reads are sent with. The snapshot does not take ownership.
+   * @param parent The parent object.
+   */
+  explicit ConfigSnapshot(ModbusQueue *queue, QObject *parent = nullptr);
+
+  /**
+   * @brief Reads all registers of a device. A refresh already running for the device is kept.
+   * @param serverAddress The address of the device.
+   */
+  void refresh(int serverAddress);
+
+  /**
+   * @brief Refreshes every device read so far in the background.
+   * @param interval The interval in ms, 0 stops the background refresh.
+   */
+  void setRefreshInterval(int interval);
+
+  /**
+   * @brief Sets the decimal point setting used to decode temperatures.
+   * @param tempDecimal The factor of one count, e.g. 0.1.
+   */
+  void setTempDecimal(double tempDecimal);
+
+  /**
+   * @brief Returns the cached value of a variable.
+   * @param serverAddress The address of the device.
+   * @param address The register address of the variable.
+   * @return The entry, not valid if the variable has not been read.
+   */
+  Entry entry(int serverAddress, quint16 address) const;
+
+  /**
+   * @brief Returns the block reads of a refresh of one device.
+   * @param serverAddress The address of the device.
+   * @return The windows, sorted by their start address, without the variables the device refused.
+   */
+  QVector<ModbusBlock> plan(int serverAddress) const;
+
+  /**
+   * @brief Checks whether a refresh of the device is running.
+   * @param serverAddress The address of the device.
+   * @return true if replies are outstanding.
+   */
+  bool isRefreshing(int serverAddress) const;
+
+  /**
+   * @brief Stores registers read elsewhere, e.g. by the status poll, and reports their changes.
+   * @param serverAddress The address of the device.
+   * @param start The first register address of the reply.
+   * @param values The register values of the reply.
+   */
+  void update(int serverAddress, quint16 start, const QVector<quint16> &values);
+
+  /**
+   * @brief Drops the cached values, so the next refresh reports every variable again.
+   */
+  void clear();
+
+signals:
+  /**
+   * @brief Emitted for a variable that was read for the first time or whose value has changed.
+   * @param serverAddress The address of the device.
+   * @param address The register address of the variable.
+   * @param value The new engineering value.
+   * @param first true if the variable had not been read before.
+   */
+  void valueChanged(int serverAddress, quint16 address, double value, bool first);
+
+  /**
+   * @brief Emitted when all blocks of a refresh have been answered.
+   * @param serverAddress The address of the device.
+   * @param changes The number of variables reported through valueChanged().
+   * @param errors The number of blocks that could not be read.
+   */
+  void refreshed(int serverAddress, int changes, int errors);
+
+private:
+  /**
+   * @brief The Pass struct collects the replies of one refresh.
+   */
+  struct Pass
+  {
+    int pending{}; /**< Blocks that have not been answered */
+    int changes{}; /**< Variables reported so far */
+    int errors{}; /**< Blocks that failed with another error than exception 02 */
+  };
+
+  ModbusQueue *queue_{nullptr}; /**< The queue the reads are sent with */
+  QTimer *refreshTimer_{nullptr}; /**< Timer of the background refresh */
+  QVector<ModbusBlock> plan_; /**< Block reads of a refresh of a device that refused nothing */
+  QHash<int, QVector<ModbusBlock>> plans_; /**< Block reads per device that refused a block */
+  QSet<quint32> unsupported_; /**< Variables refused with exception 02, keyed by key() */
+  QHash<quint32, Entry> cache_; /**< Cached values, keyed by key() */
+  QHash<int, Pass> passes_; /**< Running refreshes per device */
+  QSet<int> devices_; /**< Devices refreshed in the background */
+  double tempDecimal_{0.1}; /**< Decimal point of the temperature value */
+  mutable QMutex mutex_; /**< Guards cache_ and the plans, which are read from the GUI thread */
+
+  /**
+   * @brief Queues the read of one block.
+   */
+  void readBlock(int serverAddress, const ModbusBlock &block);
+
+  /**
+   * @brief Decodes one block reply into the cache.
+   * @return The number of variables reported through valueChanged().
+   */
+  int store(int serverAddress, quint16 start, const QVector<quint16> &values);
+
+  /**
+   * @brief Replaces a refused block of the plan of a device by its parts and returns them.
+   */
+  QVector<ModbusBlock> split(int serverAddress, const ModbusBlock &block);
+
+  /**
+   * @brief Counts down the blocks of a refresh and reports the end of the refresh.
+   */
+  void finishBlock(int serverAddress);
+
+  /**
+   * @brief Refreshes every device known to the snapshot.
+   */
+  void refreshAll();
+
+  static quint32 key(int serverAddress, quint16 address);
+};
+
+#endif // CONFIGSNAPSHOT_H
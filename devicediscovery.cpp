@@ -0,0 +1,176 @@
+#include <QDebug>
+#include <QSettings>
+#include "devicediscovery.h"
+#include "e5ccregisters.h"
+
+namespace {
+/** @brief Registers read by a probe: PV and the status double word. */
+constexpr quint16 probeCount = 4;
+/** @brief QSettings array of the inventory. */
+const char *const cacheGroup = "discovery/devices";
+}
+
+DeviceDiscovery::DeviceDiscovery(QObject *parent)
+  : QObject(parent)
+{
+  qRegisterMetaType<DeviceDiscovery::Device>("DeviceDiscovery::Device");
+  qRegisterMetaType<QList<DeviceDiscovery::Device>>("QList<DeviceDiscovery::Device>");
+}
+
+DeviceDiscovery::~DeviceDiscovery(){
+  stop();
+}
+
+/**
+ * @details Every port gets its own transport and queue without retries, so a missing address
+ * costs one probe timeout and the scan of all ports takes as long as the scan of one. The
+ * addresses of the cached inventory of a port are moved to the front of its list.
+ */
+void DeviceDiscovery::start(const QList<QSerialPortInfo> &ports){
+  stop();
+  devices_.clear();
+  probed_ = 0;
+  total_ = 0;
+  const QList<Device> cached = loadCache();
+  for (const QSerialPortInfo &info : ports) {
+    Scan *scan = new Scan;
+    scan->info = info;
+    for (const Device &device : cached) {
+      if (device.portName == info.portName() && device.slaveId >= firstId_ && device.slaveId <= lastId_
+          && !scan->ids.contains(device.slaveId)) scan->ids.append(device.slaveId);
+    }
+    for (int id = firstId_; id <= lastId_; id++) {
+      if (!scan->ids.contains(id)) scan->ids.append(id);
+    }
+
+    ModbusTransport::Settings settings;
+    settings.portName = info.portName();
+    settings.baudRate = baudRate_;
+    settings.timeout = probeTimeout_;
+    scan->transport = new ModbusTransport(this);
+    scan->transport->setSettings(settings);
+    if (!scan->transport->connectDevice()) {
+      qWarning() << "Discovery: cannot open" << info.portName() << scan->transport->errorString();
+      scan->transport->disconnectDevice();
+      scan->transport->deleteLater();
+      delete scan;
+      continue;
+    }
+    scan->queue = new ModbusQueue(this);
+    scan->queue->setAdaptiveTimeout(false);
+    scan->queue->setMaxRetries(0);
+    scan->queue->setTransport(scan->transport);
+    total_ += scan->ids.size();
+    scans_.append(scan);
+  }
+  if (scans_.isEmpty()) {
+    emit finished(devices_);
+    return;
+  }
+  const QList<Scan*> scans = scans_;
+  for (Scan *scan : scans) probeNext(scan);
+}
+
+/**
+ * @details A device that answers with an exception, e.g. because another product does not
+ * have the PV register, is listed as present but not responding.
+ */
+void DeviceDiscovery::probeNext(Scan *scan){
+  if (scan->next >= scan->ids.size()) {
+    finishScan(scan);
+    return;
+  }
+  const int id = scan->ids.at(scan->next++);
+  scan->queue->enqueue(E5ccRegisters::readRequest(E5ccRegisters::PV, probeCount), id, [this, scan, id](const ModbusResult &result) {
+    if (!scans_.contains(scan)) return;
+    probed_++;
+    if (result.isValid() || result.response.isException()) {
+      Device device;
+      device.portName = scan->info.portName();
+      device.serialNumber = scan->info.serialNumber();
+      device.slaveId = id;
+      device.baudRate = baudRate_;
+      device.responding = result.isValid();
+      device.seen = QDateTime::currentDateTime();
+      const QVector<quint16> values = result.values();
+      E5ccRegisters::at(E5ccRegisters::PV).decodeFrom(result.startAddress(), values, device.PV);
+      if (values.size() >= probeCount) device.status = (static_cast<quint32>(values.at(2)) << 16) | values.at(3);
+      devices_.append(device);
+      emit deviceFound(device);
+    }
+    emit progress(probed_, total_);
+    QMetaObject::invokeMethod(this, [this, scan]() {
+      if (scans_.contains(scan)) probeNext(scan);
+    }, Qt::QueuedConnection);
+  }, ModbusQueue::Lane::Low);
+}
+
+void DeviceDiscovery::finishScan(Scan *scan){
+  scans_.removeOne(scan);
+  scan->queue->clear();
+  scan->queue->deleteLater();
+  scan->transport->disconnectDevice();
+  scan->transport->deleteLater();
+  delete scan;
+  if (!scans_.isEmpty()) return;
+  saveCache(devices_);
+  emit finished(devices_);
+}
+
+void DeviceDiscovery::stop(){
+  const QList<Scan*> scans = scans_;
+  scans_.clear();
+  for (Scan *scan : scans) {
+    scan->queue->clear();
+    scan->queue->deleteLater();
+    scan->transport->disconnectDevice();
+    scan->transport->deleteLater();
+    delete scan;
+  }
+}
+
+QList<DeviceDiscovery::Device> DeviceDiscovery::loadCache(){
+  QSettings settings;
+  QList<Device> devices;
+  const int size = settings.beginReadArray(cacheGroup);
+  for (int i = 0; i < size; i++) {
+    settings.setArrayIndex(i);
+    Device device;
+    device.portName = settings.value("port").toString();
+    device.serialNumber = settings.value("serialNumber").toString();
+    device.slaveId = settings.value("slaveId").toInt();
+    device.baudRate = settings.value("baudRate", QSerialPort::Baud9600).toInt();
+    device.responding = settings.value("responding", true).toBool();
+    device.seen = settings.value("seen").toDateTime();
+    if (!device.portName.isEmpty() && device.slaveId > 0) devices.append(device);
+  }
+  settings.endArray();
+  return devices;
+}
+
+void DeviceDiscovery::saveCache(const QList<Device> &devices){
+  QSettings settings;
+  settings.remove(cacheGroup);
+  settings.beginWriteArray(cacheGroup, devices.size());
+  for (int i = 0; i < devices.size(); i++) {
+    const Device &device = devices.at(i);
+    settings.setArrayIndex(i);
+    settings.setValue("port", device.portName);
+    settings.setValue("serialNumber", device.serialNumber);
+    settings.setValue("slaveId", device.slaveId);
+    settings.setValue("baudRate", device.baudRate);
+    settings.setValue("responding", device.responding);
+    settings.setValue("seen", device.seen);
+  }
+  settings.endArray();
+}
+
+void DeviceDiscovery::setIdRange(int firstId, int lastId){
+  firstId_ = qBound(1, qMin(firstId, lastId), 247);
+  lastId_ = qBound(1, qMax(firstId, lastId), 247);
+}
+
+void DeviceDiscovery::setProbeTimeout(int timeout){probeTimeout_ = qMax(10, timeout);}
+void DeviceDiscovery::setBaudRate(int baudRate){baudRate_ = baudRate;}
+bool DeviceDiscovery::isRunning() const {return !scans_.isEmpty();}
+QList<DeviceDiscovery::Device> DeviceDiscovery::devices() const {return devices_;}
@@ -0,0 +1,153 @@
+/**
+ * @file devicediscovery.h
+ * @brief Declaration of the DeviceDiscovery class, which finds the E5CC controllers on the serial ports.
+ */
+
+#ifndef DEVICEDISCOVERY_H
+#define DEVICEDISCOVERY_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QList>
+#include <QSerialPortInfo>
+#include "modbusqueue.h"
+#include "modbustransport.h"
+
+/**
+ * @brief The DeviceDiscovery class probes serial ports and slave addresses for E5CC controllers.
+ *
+ * Every port is scanned at the same time with its own transport, while the slave addresses of
+ * one port are probed one after the other, since an RS-485 line carries one transaction at a
+ * time. A probe is a single read of PV and the status word with a short timeout. A device that
+ * answers, even with an exception, is reported at once with deviceFound(). Addresses found by an
+ * earlier scan are probed first. The inventory is kept in QSettings and can be loaded at the next
+ * start without touching the bus.
+ */
+class DeviceDiscovery : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * @brief The Device struct describes one controller found by a scan.
+   */
+  struct Device {
+    QString portName; /**< Serial port the controller is connected to */
+    QString serialNumber; /**< Serial number of the USB adapter of the port */
+    int slaveId{}; /**< Modbus slave address */
+    int baudRate{}; /**< Baud rate the controller answered at */
+    double PV{}; /**< Present value read by the probe */
+    quint32 status{}; /**< Status double word read by the probe */
+    bool responding{true}; /**< false if the controller answered the probe with an exception */
+    QDateTime seen; /**< Time of the probe */
+  };
+
+  /**
+   * @brief The limits enumeration defines the defaults of a scan.
+   */
+  enum limits {
+    firstIdDefault = 1, /**< Lowest slave address probed */
+    lastIdDefault = 247, /**< Highest slave address probed */
+    probeTimeoutDefault = 100 /**< Response timeout of a probe in milliseconds */
+  };
+
+  /**
+   * @brief Constructs an idle discovery.
+   * @param parent The parent object.
+   */
+  explicit DeviceDiscovery(QObject *parent = nullptr);
+
+  /**
+   * @brief Destructs the discovery and closes the ports of a running scan.
+   */
+  ~DeviceDiscovery();
+
+  /**
+   * @brief Scans the given ports. A running scan is stopped first.
+   * @param ports The serial ports to scan.
+   */
+  void start(const QList<QSerialPortInfo> &ports);
+
+  /**
+   * @brief Stops a running scan and closes its ports. The devices found so far are kept.
+   */
+  void stop();
+
+  /**
+   * @brief Sets the slave addresses probed on every port.
+   * @param firstId The lowest address.
+   * @param lastId The highest address.
+   */
+  void setIdRange(int firstId, int lastId);
+
+  void setProbeTimeout(int timeout);
+  void setBaudRate(int baudRate);
+  bool isRunning() const;
+  QList<Device> devices() const;
+
+  /**
+   * @brief Loads the inventory of the last scan.
+   * @return The devices stored by saveCache().
+   */
+  static QList<Device> loadCache();
+
+  /**
+   * @brief Stores the inventory so that the next start does not need to scan.
+   * @param devices The devices to store.
+   */
+  static void saveCache(const QList<Device> &devices);
+
+signals:
+  /**
+   * @brief Emitted as soon as a controller has answered a probe.
+   * @param device The controller.
+   */
+  void deviceFound(const DeviceDiscovery::Device &device);
+
+  /**
+   * @brief Emitted after every probe.
+   * @param probed The number of probes done.
+   * @param total The number of probes of the scan.
+   */
+  void progress(int probed, int total);
+
+  /**
+   * @brief Emitted when every port has been scanned. The inventory has been stored already.
+   * @param devices The controllers found.
+   */
+  void finished(const QList<DeviceDiscovery::Device> &devices);
+
+private:
+  /**
+   * @brief The Scan struct holds the state of the scan of one port.
+   */
+  struct Scan {
+    QSerialPortInfo info; /**< The port */
+    ModbusTransport *transport{nullptr}; /**< Transport opened on the port */
+    ModbusQueue *queue{nullptr}; /**< Queue of the probes */
+    QVector<int> ids; /**< Slave addresses in the order they are probed */
+    int next{0}; /**< Index of the next address to probe */
+  };
+
+  QList<Scan*> scans_; /**< Running scans, one per port */
+  QList<Device> devices_; /**< Controllers found */
+  int firstId_{firstIdDefault}; /**< Lowest slave address probed */
+  int lastId_{lastIdDefault}; /**< Highest slave address probed */
+  int probeTimeout_{probeTimeoutDefault}; /**< Response timeout of a probe */
+  int baudRate_{QSerialPort::Baud9600}; /**< Baud rate of the probes */
+  int probed_{0}; /**< Probes done in the running scan */
+  int total_{0}; /**< Probes of the running scan */
+
+  /**
+   * @brief Sends the next probe of a port or ends its scan.
+   */
+  void probeNext(Scan *scan);
+
+  /**
+   * @brief Closes the port of a scan and finishes the discovery after the last port.
+   */
+  void finishScan(Scan *scan);
+};
+
+Q_DECLARE_METATYPE(DeviceDiscovery::Device)
+
+#endif // DEVICEDISCOVERY_H
@@ -0,0 +1,81 @@
+#include "diagnosticsdialog.h"
+#include <QHeaderView>
+#include <QLayout>
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent) : QDialog(parent){
+  setWindowTitle("Modbus Diagnostics");
+  table_ = new QTableWidget(this);
+  const QStringList headers{"Function", "Register", "Count", "p50 [ms]", "p95 [ms]", "p99 [ms]",
+                            "Max [ms]", "Timeouts", "Exceptions", "Errors"};
+  table_->setColumnCount(headers.size());
+  table_->setHorizontalHeaderLabels(headers);
+  table_->verticalHeader()->setVisible(false);
+  table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  table_->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+  summary_ = new QLabel(this);
+  reset_ = new QPushButton("Reset");
+  connect(reset_, &QPushButton::clicked, this, &DiagnosticsDialog::resetStats);
+  refreshTimer_ = new QTimer(this);
+  refreshTimer_->setInterval(refresh);
+  connect(refreshTimer_, &QTimer::timeout, this, &DiagnosticsDialog::updateTable);
+  QHBoxLayout *bottomLayout = new QHBoxLayout;
+  bottomLayout->addWidget(summary_);
+  bottomLayout->addStretch();
+  bottomLayout->addWidget(reset_);
+  QVBoxLayout *mainLayout = new QVBoxLayout(this);
+  mainLayout->addWidget(table_);
+  mainLayout->addLayout(bottomLayout);
+  resize(760, 320);
+}
+
+void DiagnosticsDialog::setStats(ModbusStats *stats){
+  stats_ = stats;
+  updateTable();
+}
+
+void DiagnosticsDialog::showEvent(QShowEvent *event){
+  updateTable();
+  refreshTimer_->start();
+  QDialog::showEvent(event);
+}
+
+void DiagnosticsDialog::hideEvent(QHideEvent *event){
+  refreshTimer_->stop();
+  QDialog::hideEvent(event);
+}
+
+void DiagnosticsDialog::updateTable(){
+  if (stats_ == nullptr) return;
+  const QVector<ModbusStats::Entry> entries = stats_->entries();
+  table_->setRowCount(entries.size() + 1);
+  for (int i = 0; i < entries.size(); i++) {
+    const ModbusStats::Entry &entry = entries.at(i);
+    setRow(i, "0x" + QString::number(entry.functionCode, 16).rightJustified(2, '0').toUpper(),
+           "0x" + QString::number(entry.address, 16).rightJustified(4, '0').toUpper(), entry);
+  }
+  setRow(entries.size(), "Total", "", stats_->total());
+  summary_->setText(QString("Not sent (disconnected): %1").arg(stats_->unsent()));
+}
+
+void DiagnosticsDialog::resetStats(){
+  if (stats_ == nullptr) return;
+  stats_->reset();
+  updateTable();
+}
+
+void DiagnosticsDialog::setRow(int row, const QString &function, const QString &address, const ModbusStats::Entry &entry){
+  QStringList exceptions;
+  for (auto it = entry.exceptionCodes.cbegin(); it != entry.exceptionCodes.cend(); ++it) {
+    exceptions << QString("%1: %2").arg(it.key(), 2, 16, QChar('0')).arg(it.value());
+  }
+  const QStringList cells{function, address, QString::number(entry.count),
+                          QString::number(entry.percentile(0.50), 'f', 1),
+                          QString::number(entry.percentile(0.95), 'f', 1),
+                          QString::number(entry.percentile(0.99), 'f', 1),
+                          QString::number(entry.maxLatency), QString::number(entry.timeouts),
+                          exceptions.isEmpty() ? QString::number(entry.exceptions) : exceptions.join(", "),
+                          QString::number(entry.errors)};
+  for (int column = 0; column < cells.size(); column++) {
+    table_->setItem(row, column, new QTableWidgetItem(cells.at(column)));
+  }
+}
@@ -0,0 +1,73 @@
+/**
+ * @file diagnosticsdialog.h
+ * @brief Header file for the DiagnosticsDialog class
+*/
+
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include "modbusstats.h"
+
+/**
+ * @brief The DiagnosticsDialog class shows the latency and error statistics of the Modbus transactions.
+ *
+ * One row is shown per function code and start register, followed by a row with the total.
+ * The table is refreshed every second while the dialog is visible.
+ */
+class DiagnosticsDialog : public QDialog
+{
+  Q_OBJECT
+public:
+  /**
+   * @brief Constructs a DiagnosticsDialog with a given parent widget.
+   * @param parent The parent widget of the dialog.
+   */
+  explicit DiagnosticsDialog(QWidget *parent = nullptr);
+
+  /**
+   * @brief Sets the statistics shown in the dialog.
+   * @param stats The statistics. The dialog does not take ownership.
+   */
+  void setStats(ModbusStats *stats);
+
+  /**
+   * @brief The timing enumeration defines the refresh interval in milliseconds.
+   */
+  enum timing {
+    refresh = 1000 /**< The time in milliseconds between two refreshes of the table */
+  };
+
+protected:
+  void showEvent(QShowEvent *event) override;
+  void hideEvent(QHideEvent *event) override;
+
+private slots:
+  /**
+   * @brief Fills the table with the current statistics.
+   */
+  void updateTable();
+
+  /**
+   * @brief Clears the statistics.
+   */
+  void resetStats();
+
+private:
+  ModbusStats *stats_{nullptr}; /**< The statistics shown in the dialog. */
+  QTableWidget *table_{nullptr}; /**< The table of the statistics. */
+  QLabel *summary_{nullptr}; /**< The label with the number of unsent transactions. */
+  QPushButton *reset_{nullptr}; /**< The button to clear the statistics. */
+  QTimer *refreshTimer_{nullptr}; /**< The timer refreshing the table. */
+
+  /**
+   * @brief Writes one entry into a row of the table.
+   */
+  void setRow(int row, const QString &function, const QString &address, const ModbusStats::Entry &entry);
+};
+
+#endif // DIAGNOSTICSDIALOG_H
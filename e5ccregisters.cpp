@@ -0,0 +1,99 @@
+#include "e5ccregisters.h"
+
+namespace {
+void appendWord(QByteArray &data, quint16 word){
+  data.append(static_cast<char>(word >> 8)).append(static_cast<char>(word & 0xFF));
+}
+
+/** @brief Appends the start address, the number of registers, the byte count and the registers of a write. */
+void appendWrite(QByteArray &data, quint16 start, const QVector<quint16> &values){
+  appendWord(data, start);
+  appendWord(data, static_cast<quint16>(values.size()));
+  data.append(static_cast<char>(values.size() * 2));
+  for (const quint16 value : values) appendWord(data, value);
+}
+}
+
+constexpr E5ccRegister E5ccRegisters::table[];
+
+double E5ccRegister::factor(double tempDecimal) const {
+  switch (scale) {
+    case Scale::TempDecimal: return tempDecimal;
+    case Scale::Tenth: return 0.1;
+    case Scale::One: return 1.0;
+  }
+  return 1.0;
+}
+
+double E5ccRegister::decode(quint32 raw, double tempDecimal) const {
+  if (width < 2) raw &= 0xFFFF;
+  double value = raw;
+  if (isSigned) value = (width < 2) ? static_cast<qint16>(raw) : static_cast<qint32>(raw);
+  return value * factor(tempDecimal);
+}
+
+qint32 E5ccRegister::encode(double value, double tempDecimal) const {
+  const double raw = value / factor(tempDecimal);
+  return static_cast<qint32>(raw >= 0.0 ? raw + 0.5 : raw - 0.5);
+}
+
+bool E5ccRegister::decodeFrom(quint16 start, const QVector<quint16> &values, double &target, double tempDecimal) const {
+  const int offset = address - start;
+  if (offset < 0 || offset + width > values.size()) return false;
+  quint32 raw = 0;
+  for (int i = 0; i < width; i++) raw = (raw << 16) | values.at(offset + i);
+  target = decode(raw, tempDecimal);
+  return true;
+}
+
+QString E5ccRegister::label() const {
+  static const char *areas[] = {"opt", "adj", "ini", "protect", "adv"};
+  return QString("0x%1 (%2) %3 ").arg(QString::number(address, 16).rightJustified(4, '0').toUpper())
+                                  .arg(areas[static_cast<int>(area)]).arg(name);
+}
+
+const E5ccRegister& E5ccRegisters::at(quint16 address){
+  const E5ccRegister *reg = find(address);
+  Q_ASSERT_X(reg, "E5ccRegisters::at", "address is not in the register table");
+  return reg ? *reg : table[0];
+}
+
+void E5ccRegisters::appendRaw(QVector<quint16> &values, qint32 raw, int width){
+  const quint32 value = static_cast<quint32>(raw);
+  for (int shift = 16 * (width - 1); shift >= 0; shift -= 16) values.append(static_cast<quint16>((value >> shift) & 0xFFFF));
+}
+
+QModbusRequest E5ccRegisters::writeRequest(const E5ccRegister &reg, double value, double tempDecimal){
+  QVector<quint16> values;
+  appendRaw(values, reg.encode(value, tempDecimal), reg.width);
+  return writeRequest(reg.address, values);
+}
+
+/**
+ * @details The PDU data is the start address, the number of registers, the byte count and the
+ * registers.
+ */
+QModbusRequest E5ccRegisters::writeRequest(quint16 start, const QVector<quint16> &values){
+  QByteArray data;
+  appendWrite(data, start, values);
+  return QModbusRequest(QModbusPdu::WriteMultipleRegisters, data);
+}
+
+/**
+ * @details The PDU data is the read start address and count followed by the data of a write.
+ */
+QModbusRequest E5ccRegisters::readWriteRequest(quint16 start, const QVector<quint16> &values, quint16 readStart, quint16 readCount){
+  QByteArray data;
+  appendWord(data, readStart);
+  appendWord(data, readCount);
+  appendWrite(data, start, values);
+  return QModbusRequest(QModbusPdu::ReadWriteMultipleRegisters, data);
+}
+
+QModbusRequest E5ccRegisters::readRequest(quint16 start, quint16 count){
+  return QModbusRequest(QModbusPdu::ReadHoldingRegisters, start, count);
+}
+
+QModbusRequest E5ccRegisters::commandRequest(Command command){
+  return QModbusRequest(QModbusPdu::WriteSingleRegister, static_cast<quint16>(OperationCommand), static_cast<quint16>(command));
+}
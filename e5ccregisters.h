@@ -0,0 +1,274 @@
+/**
+ * @file e5ccregisters.h
+ * @brief Declaration of the E5ccRegisters class, the typed register map of the E5CC temperature controller.
+ */
+
+#ifndef E5CCREGISTERS_H
+#define E5CCREGISTERS_H
+
+#include <QModbusPdu>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief The E5ccRegister struct describes one variable of the E5CC.
+ */
+struct E5ccRegister
+{
+  /**
+   * @brief The Area enum class defines the setting areas of the E5CC.
+   */
+  enum class Area {
+    Operation, /**< Operation level, "opt" */
+    Adjustment, /**< Adjustment level, "adj" */
+    Initial, /**< Initial setting level, "ini" */
+    Protect, /**< Protect level, "protect" */
+    Advanced /**< Advanced function setting level, "adv" */
+  };
+
+  /**
+   * @brief The Scale enum class defines how a raw value is converted to an engineering value.
+   */
+  enum class Scale {
+    TempDecimal, /**< Temperature, multiplied by the decimal point setting of the controller */
+    Tenth, /**< Multiplied by 0.1, e.g. percent of MV, proportional band, current */
+    One /**< Used as is, e.g. times in seconds, set values of enumerations */
+  };
+
+  quint16 address; /**< Register address, the upper word of a double word comes first */
+  quint8 width; /**< Number of registers */
+  bool isSigned; /**< Flag indicating if the raw value is two's complement */
+  Scale scale; /**< Conversion of the raw value */
+  Area area; /**< Setting area of the variable */
+  const char *name; /**< Short description */
+
+  /**
+   * @brief Returns the factor between the raw and the engineering value.
+   * @param tempDecimal The decimal point setting of temperatures.
+   * @return The factor.
+   */
+  double factor(double tempDecimal = 0.1) const;
+
+  /**
+   * @brief Converts a raw value to an engineering value.
+   * @param raw The raw value as read from the registers.
+   * @param tempDecimal The decimal point setting of temperatures.
+   * @return The engineering value.
+   */
+  double decode(quint32 raw, double tempDecimal = 0.1) const;
+
+  /**
+   * @brief Converts an engineering value to a raw value, rounding to the nearest step.
+   * @param value The engineering value.
+   * @param tempDecimal The decimal point setting of temperatures.
+   * @return The raw value.
+   */
+  qint32 encode(double value, double tempDecimal = 0.1) const;
+
+  /**
+   * @brief Decodes the variable from the registers of a block read.
+   * @param start The address of the first register of the block.
+   * @param values The register values of the block.
+   * @param target Receives the engineering value.
+   * @param tempDecimal The decimal point setting of temperatures.
+   * @return true if the block covers the variable.
+   */
+  bool decodeFrom(quint16 start, const QVector<quint16> &values, double &target, double tempDecimal = 0.1) const;
+
+  /**
+   * @brief Returns the label used in the register combo box, e.g. "0x0000 (opt) PV".
+   * @return The label.
+   */
+  QString label() const;
+};
+
+/**
+ * @brief The E5ccRegisters class holds the register table of the E5CC and builds PDUs from it.
+ *
+ * The table covers Communication::E5CC_Address::Type and the addresses offered in the register
+ * combo box, in the order they are shown there. Requests are encoded straight into PDUs, so no
+ * value goes through a hex string.
+ */
+class E5ccRegisters
+{
+public:
+  /**
+   * @brief The Command enum class defines the operation commands written to register 0x0000.
+   */
+  enum class Command : quint16 {
+    Run = 0x0100, /**< Start the control */
+    Stop = 0x0101, /**< Stop the control */
+    ATCancel = 0x0300, /**< Cancel the autotuning */
+    AT100 = 0x0301, /**< Start a 100 % autotuning */
+    AT40 = 0x0302 /**< Start a 40 % autotuning */
+  };
+
+  /**
+   * @brief The statusBit enumeration defines the bits of the status double word at 0x0002.
+   */
+  enum statusBit : quint32 {
+    heaterBurnout = 1u << 1, /**< Heater burnout detected */
+    inputError = 1u << 4, /**< Input error */
+    outputHeating = 1u << 8, /**< Control output for heating is on */
+    atExecute = 1u << 19, /**< Autotuning is running */
+    runStop = 1u << 20, /**< Set while the control is stopped */
+    alarm1 = 1u << 24, /**< Alarm 1 output */
+    alarm2 = 1u << 25 /**< Alarm 2 output */
+  };
+
+  /**
+   * @brief The address enumeration names the registers used by the application.
+   */
+  enum address : quint16 {
+    PV = 0x0000, /**< Present value */
+    Status = 0x0002, /**< Status double word */
+    InternalSP = 0x0004, /**< Internal set point */
+    HeaterCurrent = 0x0006, /**< Heater current 1 value monitor */
+    MV = 0x0008, /**< MV monitor for heating */
+    SV = 0x0106, /**< Set point */
+    Alarm1Type = 0x0108, /**< Alarm 1 type */
+    Alarm1Upper = 0x010A, /**< Alarm value upper limit 1 */
+    Alarm1Lower = 0x010C, /**< Alarm value lower limit 1 */
+    Alarm2Type = 0x010E, /**< Alarm 2 type */
+    Alarm2Upper = 0x0110, /**< Alarm value upper limit 2 */
+    Alarm2Lower = 0x0112, /**< Alarm value lower limit 2 */
+    PID_P = 0x0A00, /**< Proportional band */
+    PID_I = 0x0A02, /**< Integral time */
+    PID_D = 0x0A04, /**< Derivative time */
+    MVupper = 0x0A0A, /**< MV upper limit */
+    MVlower = 0x0A0C, /**< MV lower limit */
+    OperationCommand = 0x0000 /**< Target of the operation commands */
+  };
+
+  static constexpr E5ccRegister table[] = {
+    {0x0000, 2, true,  E5ccRegister::Scale::TempDecimal, E5ccRegister::Area::Operation,  "PV"},
+    {0x0002, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Operation,  "Status"},
+    {0x0004, 2, true,  E5ccRegister::Scale::TempDecimal, E5ccRegister::Area::Operation,  "Internal SP"},
+    {0x0006, 2, false, E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Operation,  "heater current"},
+    {0x0008, 2, true,  E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Operation,  "MV heating"},
+    {0x000A, 2, true,  E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Operation,  "MV cooling"},
+    {0x0106, 2, true,  E5ccRegister::Scale::TempDecimal, E5ccRegister::Area::Operation,  "SP"},
+    {0x0108, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Operation,  "Alarm 1 type"},
+    {0x010A, 2, true,  E5ccRegister::Scale::TempDecimal, E5ccRegister::Area::Operation,  "Alarm 1 UL"},
+    {0x010C, 2, true,  E5ccRegister::Scale::TempDecimal, E5ccRegister::Area::Operation,  "Alarm 1 LL"},
+    {0x010E, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Operation,  "Alarm 2 type"},
+    {0x0110, 2, true,  E5ccRegister::Scale::TempDecimal, E5ccRegister::Area::Operation,  "Alarm 2 UL"},
+    {0x0112, 2, true,  E5ccRegister::Scale::TempDecimal, E5ccRegister::Area::Operation,  "Alarm 2 LL"},
+    {0x0608, 2, false, E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Operation,  "heater current 1"},
+    {0x060A, 2, true,  E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Operation,  "MV heating"},
+    {0x060C, 2, true,  E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Operation,  "MV cooling"},
+    {0x0702, 2, false, E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Operation,  "Prop. band"},
+    {0x0704, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Operation,  "Inte. time"},
+    {0x0706, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Operation,  "deri. time"},
+    {0x071E, 2, true,  E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Adjustment, "MV at stop"},
+    {0x0722, 2, true,  E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Adjustment, "MV at PV Error"},
+    {0x0A00, 2, false, E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Adjustment, "Prop. band"},
+    {0x0A02, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Adjustment, "Inte. time"},
+    {0x0A04, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Adjustment, "deri. time"},
+    {0x0A0A, 2, true,  E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Adjustment, "MV upper limit"},
+    {0x0A0C, 2, true,  E5ccRegister::Scale::Tenth,       E5ccRegister::Area::Adjustment, "MV lower limit"},
+    {0x0710, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Initial,    "Ctrl. period heating"},
+    {0x0712, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Initial,    "Ctrl. period cooling"},
+    {0x0D06, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Initial,    "Ctrl. output 1 current"},
+    {0x0D08, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Initial,    "Ctrl. output 2 current"},
+    {0x0D1E, 2, true,  E5ccRegister::Scale::TempDecimal, E5ccRegister::Area::Initial,    "SP upper limit"},
+    {0x0D20, 2, true,  E5ccRegister::Scale::TempDecimal, E5ccRegister::Area::Initial,    "SP lower limit"},
+    {0x0D22, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Initial,    "Std heating/cooling"},
+    {0x0D24, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Initial,    "Direct/Reverse opt."},
+    {0x0D28, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Initial,    "PID on/off"},
+    {0x0500, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Protect,    "Opt/Adj protect"},
+    {0x0502, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Protect,    "Init/Comm protect"},
+    {0x0504, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Protect,    "Setting Chg. protect"},
+    {0x0506, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Protect,    "PF key protect"},
+    {0x0E0C, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Advanced,   "Ctrl. output 1 Assignment"},
+    {0x0E0E, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Advanced,   "Ctrl. output 2 Assignment"},
+    {0x0E20, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Advanced,   "Aux. output 1 Assignment"},
+    {0x0E22, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Advanced,   "Aux. output 2 Assignment"},
+    {0x0E24, 2, false, E5ccRegister::Scale::One,         E5ccRegister::Area::Advanced,   "Aux. output 3 Assignment"}
+  };
+
+  /**
+   * @brief Returns the number of entries of the table.
+   */
+  static constexpr int count(){return sizeof(table) / sizeof(table[0]);}
+
+  /**
+   * @brief Looks up a register by address.
+   * @param address The register address.
+   * @param index The entry to start the search at.
+   * @return The entry, or nullptr if the address is not in the table.
+   */
+  static constexpr const E5ccRegister* find(quint16 address, int index = 0){
+    return index >= count() ? nullptr : (table[index].address == address ? &table[index] : find(address, index + 1));
+  }
+
+  /**
+   * @brief Returns the first address after the last register of the table.
+   * @param index The entry to start the search at.
+   * @param last The end found in the entries before @p index.
+   * @return The largest address plus width of all entries.
+   */
+  static constexpr int end(int index = 0, int last = 0){
+    return index >= count() ? last : end(index + 1, table[index].address + table[index].width > last
+                                                    ? table[index].address + table[index].width : last);
+  }
+
+  /**
+   * @brief Looks up a register that must be in the table.
+   * @param address The register address.
+   * @return The entry.
+   */
+  static const E5ccRegister& at(quint16 address);
+
+  /**
+   * @brief Builds a WriteMultipleRegisters request for one variable.
+   * @param reg The register.
+   * @param value The engineering value.
+   * @param tempDecimal The decimal point setting of temperatures.
+   * @return The request PDU.
+   */
+  static QModbusRequest writeRequest(const E5ccRegister &reg, double value, double tempDecimal = 0.1);
+
+  /**
+   * @brief Builds a WriteMultipleRegisters request for a block of registers.
+   * @param start The first register address.
+   * @param values The register values.
+   * @return The request PDU.
+   */
+  static QModbusRequest writeRequest(quint16 start, const QVector<quint16> &values);
+
+  /**
+   * @brief Builds a ReadWriteMultipleRegisters request that writes a block and reads a block.
+   * @param start The first register address written.
+   * @param values The register values written.
+   * @param readStart The first register address read.
+   * @param readCount The number of registers read.
+   * @return The request PDU. The device writes before it reads, so the reply carries the new values.
+   */
+  static QModbusRequest readWriteRequest(quint16 start, const QVector<quint16> &values, quint16 readStart, quint16 readCount);
+
+  /**
+   * @brief Builds a ReadHoldingRegisters request for a block of registers.
+   * @param start The first register address.
+   * @param count The number of registers.
+   * @return The request PDU.
+   */
+  static QModbusRequest readRequest(quint16 start, quint16 count);
+
+  /**
+   * @brief Builds the WriteSingleRegister request of an operation command.
+   * @param command The command.
+   * @return The request PDU.
+   */
+  static QModbusRequest commandRequest(Command command);
+
+  /**
+   * @brief Appends a raw value to register values, upper word first.
+   * @param values The register values.
+   * @param raw The raw value.
+   * @param width The number of registers of the value.
+   */
+  static void appendRaw(QVector<quint16> &values, qint32 raw, int width = 2);
+};
+
+#endif // E5CCREGISTERS_H
@@ -0,0 +1,207 @@
+#include <QRandomGenerator>
+#include <QThread>
+#include "e5ccsimulator.h"
+#include "e5ccregisters.h"
+
+namespace {
+// register addresses of the E5CC, each one a double word with the upper word first
+const quint16 addressPV = 0x0000;
+const quint16 addressStatus = 0x0002;
+const quint16 addressInternalSP = 0x0004;
+const quint16 addressHeaterCurrent = 0x0006;
+const quint16 addressMV = 0x0008;
+const quint16 addressSV = 0x0106;
+const quint16 addressAlarm1Type = 0x0108;
+const quint16 addressAlarm1Upper = 0x010A;
+const quint16 addressAlarm2Type = 0x010E;
+const quint16 addressAlarm2Upper = 0x0110;
+const quint16 addressHeaterCurrent1 = 0x0608;
+const quint16 addressMVHeating = 0x060A;
+const quint16 addressPID_P = 0x0A00;
+const quint16 addressPID_I = 0x0A02;
+const quint16 addressPID_D = 0x0A04;
+const quint16 addressMVupper = 0x0A0A;
+const quint16 addressMVlower = 0x0A0C;
+const quint16 registerCount = static_cast<quint16>(E5ccRegisters::end()); // every register of the table is served
+
+/**
+ * @brief Checks an alarm of type 2 (upper limit deviation) or 8 (absolute upper limit).
+ */
+bool alarmActive(int type, double upper, double PV, double SV){
+  switch (type) {
+    case 2: return PV - SV > upper;
+    case 8: return PV > upper;
+    default: return false;
+  }
+}
+}
+
+E5ccSimulator::E5ccSimulator(QObject *parent)
+  : QModbusTcpServer(parent)
+{
+  QModbusDataUnitMap map;
+  map.insert(QModbusDataUnit::HoldingRegisters, QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 0, registerCount));
+  setMap(map);
+  writeDouble(addressPV, plant_.ambient, 0.1);
+  writeDouble(addressSV, 0.0, 0.1);
+  writeDouble(addressPID_P, 8.0, 0.1);
+  writeDouble(addressPID_I, 233.0, 1.0);
+  writeDouble(addressPID_D, 40.0, 1.0);
+  writeDouble(addressMVupper, 100.0, 0.1);
+  writeDouble(addressMVlower, 0.0, 0.1);
+  writeDouble(addressStatus, E5ccRegisters::runStop, 1.0);
+  temperature_ = plant_.ambient;
+  lastPV_ = plant_.ambient;
+  stepTimer_ = new QTimer(this);
+  stepTimer_->setInterval(step);
+  connect(stepTimer_, &QTimer::timeout, this, &E5ccSimulator::stepModel);
+}
+
+bool E5ccSimulator::start(const QString &host, int port){
+  setConnectionParameter(QModbusDevice::NetworkAddressParameter, host);
+  setConnectionParameter(QModbusDevice::NetworkPortParameter, port);
+  if (!connectDevice()) return false;
+  clock_.start();
+  stepTimer_->start();
+  return true;
+}
+
+void E5ccSimulator::stop(){
+  stepTimer_->stop();
+  disconnectDevice();
+}
+
+/**
+ * @details The PID loop follows the E5CC convention: the proportional band in kelvin, the
+ * integral and derivative time in seconds. The derivative acts on PV only. The integral is
+ * frozen while the output sits at one of its limits.
+ */
+void E5ccSimulator::stepModel(){
+  mutex_.lock();
+  const Plant plant = plant_;
+  const Faults faults = faults_;
+  const double dt = clock_.restart() / 1000.0 * timeScale_;
+  mutex_.unlock();
+  if (dt <= 0.0) return;
+  simTime_ += dt;
+
+  const double SV = readDouble(addressSV, 0.1);
+  const double band = readDouble(addressPID_P, 0.1);
+  const double integralTime = readDouble(addressPID_I, 1.0);
+  const double derivativeTime = readDouble(addressPID_D, 1.0);
+  const double upper = readDouble(addressMVupper, 0.1);
+  const double lower = readDouble(addressMVlower, 0.1);
+  const double PV = readDouble(addressPV, 0.1);
+
+  if (running_) {
+    const double error = SV - PV;
+    const double integral = integral_ + error * dt;
+    const double derivative = -(PV - lastPV_) / dt;
+    const double output = 100.0 / qMax(0.1, band) * (error + (integralTime > 0.0 ? integral / integralTime : 0.0)
+                                               + derivativeTime * derivative);
+    const double bounded = qBound(lower, output, upper);
+    if (output == bounded) integral_ = integral;
+    MV_ = bounded;
+  } else {
+    MV_ = 0.0;
+    integral_ = 0.0;
+  }
+  lastPV_ = PV;
+  if (atRemaining_ > 0.0) atRemaining_ = qMax(0.0, atRemaining_ - dt);
+
+  outputs_.enqueue(qMakePair(simTime_, faults.heaterBroken ? 0.0 : MV_));
+  const double heating = delayedOutput(plant.deadTime) / 100.0 * plant.gain;
+  mutex_.lock();
+  temperature_ += (plant.ambient + heating - temperature_) * dt / qMax(1.0, plant.timeConstant);
+  const double temperature = temperature_;
+  mutex_.unlock();
+
+  const double current = faults.heaterBroken ? 0.0 : qMax(0.0, MV_) / 100.0 * plant.heaterCurrent;
+  if (!faults.sensorFrozen) writeDouble(addressPV, temperature, 0.1);
+  writeDouble(addressMV, MV_, 0.1);
+  writeDouble(addressMVHeating, MV_, 0.1);
+  writeDouble(addressInternalSP, SV, 0.1);
+  writeDouble(addressHeaterCurrent, current, 0.1);
+  writeDouble(addressHeaterCurrent1, current, 0.1);
+
+  const double shownPV = readDouble(addressPV, 0.1);
+  quint32 status = 0;
+  if (!running_) status |= E5ccRegisters::runStop;
+  if (atRemaining_ > 0.0) status |= E5ccRegisters::atExecute;
+  if (MV_ > 0.0) status |= E5ccRegisters::outputHeating;
+  if (faults.heaterBroken && MV_ > 0.0) status |= E5ccRegisters::heaterBurnout;
+  if (alarmActive(static_cast<int>(readDouble(addressAlarm1Type, 1.0)), readDouble(addressAlarm1Upper, 0.1), shownPV, SV)) status |= E5ccRegisters::alarm1;
+  if (alarmActive(static_cast<int>(readDouble(addressAlarm2Type, 1.0)), readDouble(addressAlarm2Upper, 0.1), shownPV, SV)) status |= E5ccRegisters::alarm2;
+  writeDouble(addressStatus, status, 1.0);
+}
+
+double E5ccSimulator::delayedOutput(double deadTime){
+  while (!outputs_.isEmpty() && outputs_.head().first <= simTime_ - deadTime) {
+    appliedOutput_ = outputs_.dequeue().second;
+  }
+  return appliedOutput_;
+}
+
+/**
+ * @details The delay blocks the thread of the server, like a busy controller blocks the line.
+ */
+QModbusResponse E5ccSimulator::processRequest(const QModbusPdu &request){
+  mutex_.lock();
+  const Faults faults = faults_;
+  mutex_.unlock();
+  QRandomGenerator *random = QRandomGenerator::global();
+  int delay = faults.latency + (faults.jitter > 0 ? random->bounded(faults.jitter + 1) : 0);
+  if (faults.timeoutRate > 0.0 && random->generateDouble() < faults.timeoutRate) delay = faults.timeoutDelay;
+  if (delay > 0) QThread::msleep(static_cast<unsigned long>(delay));
+  if (faults.exceptionRate > 0.0 && random->generateDouble() < faults.exceptionRate) {
+    return QModbusExceptionResponse(request.functionCode(), QModbusExceptionResponse::ServerDeviceFailure);
+  }
+  if (request.functionCode() == QModbusPdu::WriteSingleRegister) {
+    quint16 address = 0;
+    quint16 value = 0;
+    request.decodeData(&address, &value);
+    if (address == 0x0000) return command(request);
+  }
+  return QModbusTcpServer::processRequest(request);
+}
+
+/**
+ * @details Commands are 01 00 (run), 01 01 (stop) and 03 00, 03 01, 03 02 (AT cancel, 100 % AT,
+ * 40 % AT). Unknown commands are refused with IllegalDataValue.
+ */
+QModbusResponse E5ccSimulator::command(const QModbusPdu &request){
+  quint16 address = 0;
+  quint16 value = 0;
+  request.decodeData(&address, &value);
+  switch (value) {
+    case 0x0100: running_ = true; break;
+    case 0x0101: running_ = false; atRemaining_ = 0.0; break;
+    case 0x0300: atRemaining_ = 0.0; break;
+    case 0x0301:
+    case 0x0302: if (running_) atRemaining_ = atDuration / 1000.0; break;
+    default:
+      return QModbusExceptionResponse(request.functionCode(), QModbusExceptionResponse::IllegalDataValue);
+  }
+  return QModbusResponse(request.functionCode(), request.data());
+}
+
+double E5ccSimulator::readDouble(quint16 address, double scale) const {
+  quint16 upper = 0;
+  quint16 lower = 0;
+  data(QModbusDataUnit::HoldingRegisters, address, &upper);
+  data(QModbusDataUnit::HoldingRegisters, address + 1, &lower);
+  return static_cast<qint32>((static_cast<quint32>(upper) << 16) | lower) * scale;
+}
+
+void E5ccSimulator::writeDouble(quint16 address, double value, double scale){
+  const qint32 raw = static_cast<qint32>(value >= 0.0 ? value / scale + 0.5 : value / scale - 0.5);
+  setData(QModbusDataUnit::HoldingRegisters, address, static_cast<quint16>(static_cast<quint32>(raw) >> 16));
+  setData(QModbusDataUnit::HoldingRegisters, address + 1, static_cast<quint16>(raw & 0xFFFF));
+}
+
+void E5ccSimulator::setPlant(const Plant &plant){QMutexLocker locker(&mutex_); plant_ = plant;}
+void E5ccSimulator::setFaults(const Faults &faults){QMutexLocker locker(&mutex_); faults_ = faults;}
+void E5ccSimulator::setTimeScale(double scale){QMutexLocker locker(&mutex_); timeScale_ = qMax(0.0, scale);}
+E5ccSimulator::Plant E5ccSimulator::plant() const {QMutexLocker locker(&mutex_); return plant_;}
+E5ccSimulator::Faults E5ccSimulator::faults() const {QMutexLocker locker(&mutex_); return faults_;}
+double E5ccSimulator::plantTemperature() const {QMutexLocker locker(&mutex_); return temperature_;}
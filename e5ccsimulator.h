@@ -0,0 +1,148 @@
+/**
+ * @file e5ccsimulator.h
+ * @brief Declaration of the E5ccSimulator class, a Modbus TCP stand-in for an E5CC with a heater model.
+ */
+
+#ifndef E5CCSIMULATOR_H
+#define E5CCSIMULATOR_H
+
+#include <QModbusTcpServer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QQueue>
+#include <QTimer>
+
+/**
+ * @brief The E5ccSimulator class answers Modbus TCP requests like an E5CC temperature controller.
+ *
+ * The registers of E5CC_Address::Type and setupCombBox are served as double words. The
+ * operation commands written to 0x0000 (run, stop, AT) are interpreted like on the device. The
+ * present value comes from a first-order-plus-dead-time heater model driven by the simulator's
+ * own PID loop, which uses the proportional band, integral and derivative time and the MV limits
+ * written by the client.
+ *
+ * Every request can be delayed by a configurable latency, and faults can be injected: delays
+ * longer than the client timeout, exception responses, a frozen sensor and a broken heater.
+ * Run each instance in its own thread, since the latency blocks the thread of the server. Several
+ * devices are simulated by several instances listening on different ports.
+ */
+class E5ccSimulator : public QModbusTcpServer
+{
+  Q_OBJECT
+public:
+  /**
+   * @brief The Plant struct holds the parameters of the heater model.
+   */
+  struct Plant {
+    double ambient{25.0}; /**< Ambient temperature in degrees Celsius */
+    double gain{300.0}; /**< Temperature rise above ambient at 100 % output in kelvin */
+    double timeConstant{600.0}; /**< Time constant of the furnace in seconds */
+    double deadTime{20.0}; /**< Delay between output and temperature response in seconds */
+    double heaterCurrent{10.0}; /**< Heater current at 100 % output in amperes */
+  };
+
+  /**
+   * @brief The Faults struct holds the latency and the injected faults.
+   */
+  struct Faults {
+    int latency{20}; /**< Delay of every response in milliseconds */
+    int jitter{5}; /**< Random additional delay in milliseconds */
+    int timeoutDelay{1500}; /**< Delay of a response that should time out in milliseconds */
+    double timeoutRate{0.0}; /**< Probability of a response delayed by timeoutDelay */
+    double exceptionRate{0.0}; /**< Probability of a ServerDeviceFailure exception */
+    bool sensorFrozen{false}; /**< The present value stops following the plant */
+    bool heaterBroken{false}; /**< The output no longer heats and draws no current */
+  };
+
+  /**
+   * @brief The timing enumeration defines the default timing of the simulator in milliseconds.
+   */
+  enum timing {
+    step = 100, /**< Time between two steps of the model */
+    atDuration = 60000 /**< Simulated duration of an autotuning */
+  };
+
+  /**
+   * @brief Constructs a stopped controller at ambient temperature.
+   * @param parent The parent object.
+   */
+  explicit E5ccSimulator(QObject *parent = nullptr);
+
+  /**
+   * @brief Starts listening and stepping the model. Call it in the thread the simulator lives in.
+   * @param host The address to listen on.
+   * @param port The TCP port to listen on.
+   * @return true if the server is listening.
+   */
+  bool start(const QString &host, int port);
+
+  /**
+   * @brief Stops the model and closes the server.
+   */
+  void stop();
+
+  void setPlant(const Plant &plant);
+  void setFaults(const Faults &faults);
+
+  /**
+   * @brief Sets how much faster than real time the model runs.
+   * @param scale The factor, e.g. 60 to simulate one minute per second.
+   */
+  void setTimeScale(double scale);
+
+  Plant plant() const;
+  Faults faults() const;
+
+  /**
+   * @brief Returns the temperature of the plant, independent of a frozen sensor.
+   * @return The temperature in degrees Celsius.
+   */
+  double plantTemperature() const;
+
+protected:
+  /**
+   * @brief Answers a request after the configured latency and with the injected faults.
+   * @param request The request PDU.
+   * @return The response PDU.
+   */
+  QModbusResponse processRequest(const QModbusPdu &request) override;
+
+private:
+  mutable QMutex mutex_; /**< Mutex guarding the parameters set from other threads */
+  QTimer *stepTimer_{nullptr}; /**< Timer stepping the model */
+  QElapsedTimer clock_; /**< Real time since the last step */
+  Plant plant_; /**< Parameters of the heater model */
+  Faults faults_; /**< Latency and injected faults */
+  double timeScale_{1.0}; /**< Simulated seconds per real second */
+  double simTime_{0.0}; /**< Simulated time in seconds */
+  double temperature_{25.0}; /**< Temperature of the plant, guarded by mutex_ */
+  double integral_{0.0}; /**< Integral of the control deviation */
+  double lastPV_{25.0}; /**< Present value of the previous step */
+  double MV_{0.0}; /**< Output of the PID loop in percent */
+  double appliedOutput_{0.0}; /**< Output that has reached the plant after the dead time */
+  double atRemaining_{0.0}; /**< Simulated seconds left of a running autotuning */
+  bool running_{false}; /**< Flag indicating if the control runs */
+  QQueue<QPair<double, double>> outputs_; /**< Time and output of past steps for the dead time */
+
+  /**
+   * @brief Advances the PID loop and the heater model by the elapsed time.
+   */
+  void stepModel();
+
+  /**
+   * @brief Interprets an operation command written to 0x0000.
+   * @param request The WriteSingleRegister request.
+   * @return The echo response.
+   */
+  QModbusResponse command(const QModbusPdu &request);
+
+  /**
+   * @brief Returns the output that reached the plant after the dead time.
+   */
+  double delayedOutput(double deadTime);
+
+  double readDouble(quint16 address, double scale) const;
+  void writeDouble(quint16 address, double value, double scale);
+};
+
+#endif // E5CCSIMULATOR_H
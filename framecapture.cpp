@@ -0,0 +1,108 @@
+#include <QDataStream>
+#include <QMutexLocker>
+#include "framecapture.h"
+#include "modbusqueue.h"
+
+FrameCapture::~FrameCapture(){
+  stop();
+}
+
+bool FrameCapture::start(const QString &fileName){
+  QMutexLocker locker(&mutex_);
+  if (file_.isOpen()) file_.close();
+  file_.setFileName(fileName);
+  if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+  QDataStream stream(&file_);
+  stream << static_cast<quint32>(magic) << static_cast<quint32>(version);
+  count_ = 0;
+  clock_.start();
+  return true;
+}
+
+void FrameCapture::stop(){
+  QMutexLocker locker(&mutex_);
+  if (file_.isOpen()) file_.close();
+}
+
+/**
+ * @details A record is written in one piece and flushed, so a capture that ends with a crash
+ * is still readable up to the last transaction.
+ */
+void FrameCapture::record(const ModbusResult &result, int lane, int attempt, qint64 roundTrip){
+  QMutexLocker locker(&mutex_);
+  if (!file_.isOpen()) return;
+  const qint64 now = clock_.nsecsElapsed();
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+  stream << static_cast<qint64>((now - roundTrip) / 1000) << static_cast<quint32>(qBound<qint64>(0, roundTrip / 1000, 0xFFFFFFFF))
+         << static_cast<quint8>(result.serverAddress) << static_cast<quint8>(lane) << static_cast<quint8>(qMin(attempt, 0xFF))
+         << static_cast<quint8>(result.error);
+  appendPdu(data, result.request);
+  appendPdu(data, result.response);
+  file_.write(data);
+  file_.flush();
+  count_++;
+}
+
+/**
+ * @details QModbusPdu::functionCode() strips the exception bit, so it is put back here. Restored
+ * with setFunctionCode(), a replayed exception response is again reported by isException().
+ */
+void FrameCapture::appendPdu(QByteArray &data, const QModbusPdu &pdu){
+  const QByteArray payload = pdu.data();
+  quint8 code = static_cast<quint8>(pdu.functionCode());
+  if (pdu.isException()) code |= QModbusPdu::ExceptionByte;
+  data.append(static_cast<char>(code));
+  data.append(static_cast<char>(qMin(payload.size(), 0xFF)));
+  data.append(payload.left(0xFF));
+}
+
+bool FrameCapture::load(const QString &fileName, QVector<Record> &records, QString *error){
+  records.clear();
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    if (error) *error = file.errorString();
+    return false;
+  }
+  QDataStream stream(&file);
+  quint32 fileMagic = 0;
+  quint32 fileVersion = 0;
+  stream >> fileMagic >> fileVersion;
+  if (fileMagic != magic || fileVersion != version) {
+    if (error) *error = QStringLiteral("not a Modbus capture of version %1").arg(version);
+    return false;
+  }
+  auto readPdu = [&stream](QModbusPdu &pdu) {
+    quint8 code = 0;
+    quint8 size = 0;
+    stream >> code >> size;
+    QByteArray payload(size, Qt::Uninitialized);
+    if (stream.readRawData(payload.data(), size) != size) return false;
+    pdu.setFunctionCode(static_cast<QModbusPdu::FunctionCode>(code));
+    pdu.setData(payload);
+    return stream.status() == QDataStream::Ok;
+  };
+  while (!stream.atEnd()) {
+    Record record;
+    qint64 sent = 0;
+    quint32 roundTrip = 0;
+    quint8 serverAddress = 0;
+    quint8 lane = 0;
+    quint8 attempt = 0;
+    quint8 code = 0;
+    stream >> sent >> roundTrip >> serverAddress >> lane >> attempt >> code;
+    if (!readPdu(record.request) || !readPdu(record.response)) break;
+    record.sent = sent;
+    record.roundTrip = roundTrip;
+    record.serverAddress = serverAddress;
+    record.lane = lane;
+    record.attempt = attempt;
+    record.error = static_cast<QModbusDevice::Error>(code);
+    records.append(record);
+  }
+  return true;
+}
+
+bool FrameCapture::isRecording() const {QMutexLocker locker(&mutex_); return file_.isOpen();}
+QString FrameCapture::fileName() const {QMutexLocker locker(&mutex_); return file_.fileName();}
+quint64 FrameCapture::count() const {QMutexLocker locker(&mutex_); return count_;}
@@ -0,0 +1,102 @@
+/**
+ * @file framecapture.h
+ * @brief Declaration of the FrameCapture class, which records the Modbus transactions to a binary file.
+ */
+
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QModbusDevice>
+#include <QModbusPdu>
+#include <QMutex>
+#include <QVector>
+
+struct ModbusResult;
+
+/**
+ * @brief The FrameCapture class writes every Modbus transaction to a compact binary capture file.
+ *
+ * A record holds the time the request was sent on a monotonic clock, the round trip, the slave
+ * address, lane, attempt and error of the transaction, followed by the request and the response
+ * PDU. Checksum and MBAP header are handled inside the Modbus client and are not recorded. The
+ * file starts with a magic and a version. load() reads a capture back, so ModbusTransport can
+ * replay it through the same decode path as a live bus. Recording is guarded by a mutex, so the
+ * capture can be started and stopped from the GUI thread while the bus thread records.
+ */
+class FrameCapture
+{
+public:
+  /**
+   * @brief The Record struct holds one captured transaction.
+   */
+  struct Record {
+    qint64 sent{0}; /**< Time the request was sent, in microseconds since the capture started */
+    qint64 roundTrip{0}; /**< Time until the reply or the timeout, in microseconds */
+    int serverAddress{}; /**< Address of the device */
+    int lane{}; /**< ModbusQueue::Lane of the request */
+    int attempt{}; /**< Number of times the request had been sent before */
+    QModbusDevice::Error error{QModbusDevice::NoError}; /**< Error of the transaction */
+    QModbusRequest request; /**< The request PDU */
+    QModbusResponse response; /**< The response PDU, empty after a timeout */
+  };
+
+  /**
+   * @brief The format enumeration defines the header of a capture file.
+   */
+  enum format : quint32 {
+    magic = 0x4F4D4346, /**< "OMCF" */
+    version = 1 /**< Version of the record layout */
+  };
+
+  FrameCapture() = default;
+  ~FrameCapture();
+
+  /**
+   * @brief Starts recording to a file. A running capture is closed first.
+   * @param fileName The capture file, truncated if it exists.
+   * @return false if the file cannot be written.
+   */
+  bool start(const QString &fileName);
+
+  /**
+   * @brief Stops recording and closes the file.
+   */
+  void stop();
+
+  /**
+   * @brief Records a completed transaction.
+   * @param result The result of the transaction.
+   * @param lane The lane of the request.
+   * @param attempt The number of times the request had been sent before.
+   * @param roundTrip The time in nanoseconds from sending the request to its completion.
+   */
+  void record(const ModbusResult &result, int lane, int attempt, qint64 roundTrip);
+
+  bool isRecording() const;
+  QString fileName() const;
+  quint64 count() const;
+
+  /**
+   * @brief Reads a capture file.
+   * @param fileName The capture file.
+   * @param records Receives the records in the order they were written.
+   * @param error Receives the reason if the file cannot be read.
+   * @return false if the file is missing or not a capture.
+   */
+  static bool load(const QString &fileName, QVector<Record> &records, QString *error = nullptr);
+
+private:
+  mutable QMutex mutex_; /**< Mutex guarding the file */
+  QFile file_; /**< The capture file */
+  QElapsedTimer clock_; /**< Monotonic clock started with the capture */
+  quint64 count_{0}; /**< Records written */
+
+  /**
+   * @brief Appends a PDU as function code with its exception bit, length and data.
+   */
+  static void appendPdu(QByteArray &data, const QModbusPdu &pdu);
+};
+
+#endif // FRAMECAPTURE_H
@@ -1,5 +1,6 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "e5ccregisters.h"
 
 void MainWindow::setupPlot(){
   plot = ui->plot;
@@ -60,50 +61,10 @@ void MainWindow::setupCombBox(){
   ui->comboBox_Mode->setItemData(2, QBrush(Qt::blue), Qt::ForegroundRole);
   ui->comboBox_Mode->setItemData(3, QBrush(Qt::darkGreen), Qt::ForegroundRole);
 
-  //============= some useful addresses
-  ui->comboBox_MemAddress->addItem("0x0000 (opt) PV "                     , 0x0000);
-  ui->comboBox_MemAddress->addItem("0x0008 (opt) MV heating "             , 0x0008);
-  ui->comboBox_MemAddress->addItem("0x000A (opt) MV cooling "            , 0x000A);
-  ui->comboBox_MemAddress->addItem("0x0106 (opt) SP "                     , 0x0106);
-  ui->comboBox_MemAddress->addItem("0x0108 (opt) Alarm 1 type "           , 0x0108);
-  ui->comboBox_MemAddress->addItem("0x010A (opt) Alarm 1 UL "             , 0x010A);
-  ui->comboBox_MemAddress->addItem("0x010C (opt) Alarm 1 LL "             , 0x010C);
-  ui->comboBox_MemAddress->addItem("0x010E (opt) Alarm 2 type "           , 0x010E);
-  ui->comboBox_MemAddress->addItem("0x0110 (opt) Alarm 2 UL "             , 0x0110);
-  ui->comboBox_MemAddress->addItem("0x0112 (opt) Alarm 2 LL "             , 0x0112);
-  ui->comboBox_MemAddress->addItem("0x0608 (opt) heater current 1 "       , 0x0608);
-  ui->comboBox_MemAddress->addItem("0x060A (opt) MV heating "             , 0x060A);
-  ui->comboBox_MemAddress->addItem("0x060C (opt) MV cooling "             , 0x060C);
-  ui->comboBox_MemAddress->addItem("0x0702 (opt) Prop. band "             , 0x0702);
-  ui->comboBox_MemAddress->addItem("0x0704 (opt) Inte. time "             , 0x0704);
-  ui->comboBox_MemAddress->addItem("0x0706 (opt) deri. time "             , 0x0706);
-  ui->comboBox_MemAddress->addItem("0x071E (adj) MV at stop "             , 0x071E);
-  ui->comboBox_MemAddress->addItem("0x0722 (adj) MV at PV Error "         , 0x0722);
-  //! modified "0x0A0A -> ""0x0A00" in part of the  first argument in addItem function @ 2023/2/27 by Daisuke Miura.
-  //! This is a display issue on the GUI and has nothing to do with functionality.
-  ui->comboBox_MemAddress->addItem("0x0A00 (adj) Prop. band "             , 0x0A00);
-  ui->comboBox_MemAddress->addItem("0x0A02 (adj) Inte. time "             , 0x0A02);
-  ui->comboBox_MemAddress->addItem("0x0A04 (adj) deri. time "             , 0x0A04);
-  ui->comboBox_MemAddress->addItem("0x0A0A (adj) MV upper limit "         , 0x0A0A);
-  ui->comboBox_MemAddress->addItem("0x0A0C (adj) MV lower limit "         , 0x0A0C);
-  ui->comboBox_MemAddress->addItem("0x0710 (ini) Ctrl. period heating "   , 0x0710);
-  ui->comboBox_MemAddress->addItem("0x0712 (ini) Ctrl. period cooling "   , 0x0712);
-  ui->comboBox_MemAddress->addItem("0x0D06 (ini) Ctrl. output 1 current " , 0x0D06);
-  ui->comboBox_MemAddress->addItem("0x0D08 (ini) Ctrl. output 2 current " , 0x0D08);
-  ui->comboBox_MemAddress->addItem("0x0D1E (ini) SP upper limit "         , 0x0D1E);
-  ui->comboBox_MemAddress->addItem("0x0D20 (ini) SP lower limit "         , 0x0D20);
-  ui->comboBox_MemAddress->addItem("0x0D22 (ini) Std heating/cooling "    , 0x0D22);
-  ui->comboBox_MemAddress->addItem("0x0D24 (ini) Direct/Reverse opt. "    , 0x0D24);
-  ui->comboBox_MemAddress->addItem("0x0D28 (ini) PID on/off "             , 0x0D28);
-  ui->comboBox_MemAddress->addItem("0x0500 (protect) Opt/Adj protect "       , 0x0500);
-  ui->comboBox_MemAddress->addItem("0x0502 (protect) Init/Comm protect "     , 0x0502);
-  ui->comboBox_MemAddress->addItem("0x0504 (protect) Setting Chg. protect "  , 0x0504);
-  ui->comboBox_MemAddress->addItem("0x0506 (protect) PF key protect "        , 0x0506);
-  ui->comboBox_MemAddress->addItem("0x0E0C (adv) Ctrl. output 1 Assignment "   , 0x0E0C);
-  ui->comboBox_MemAddress->addItem("0x0E0E (adv) Ctrl. output 2 Assignment "   , 0x0E0E);
-  ui->comboBox_MemAddress->addItem("0x0E20 (adv) Aux. output 1 Assignment "    , 0x0E20);
-  ui->comboBox_MemAddress->addItem("0x0E22 (adv) Aux. output 2 Assignment "    , 0x0E22);
-  ui->comboBox_MemAddress->addItem("0x0E24 (adv) Aux. output 3 Assignment "    , 0x0E24);
+  //============= some useful addresses, generated from the register table
+  for (const E5ccRegister &reg : E5ccRegisters::table) {
+    ui->comboBox_MemAddress->addItem(reg.label(), reg.address);
+  }
   comboxEnable = true;
 }
 
@@ -163,6 +124,7 @@ void MainWindow::panalOnOff(bool IO)
 
 void MainWindow::setupDialog(){
   helpDialog_ = new HelpDialog(this);
+  diagnosticsDialog_ = new DiagnosticsDialog(this);
 
   //! plotDialog
   plotDialog_ = new PlotDialog(this);
@@ -177,6 +139,27 @@ void MainWindow::setupDialog(){
   joinDialogK_ = new JoinLINEDialog(this, ":/LINEQR_Kyushu.jpg");
 }
 
+void MainWindow::setupSerialMenu(){
+  QMenu *menu = ui->menuConfigure->addMenu(tr("Serial Settings"));
+  auto addGroup = [this, menu](const QList<QPair<QString, int>> &items, int checked) {
+    if (!menu->isEmpty()) menu->addSeparator();
+    QActionGroup *group = new QActionGroup(this);
+    for (const auto &item : items) {
+      QAction *action = menu->addAction(item.first);
+      action->setCheckable(true);
+      action->setData(item.second);
+      action->setChecked(item.second == checked);
+      group->addAction(action);
+    }
+    return group;
+  };
+  baudGroup_ = addGroup({{tr("Auto-detect"), 0}, {"57600 baud", QSerialPort::Baud57600}, {"38400 baud", QSerialPort::Baud38400},
+                         {"19200 baud", QSerialPort::Baud19200}, {"9600 baud", QSerialPort::Baud9600}}, 0);
+  parityGroup_ = addGroup({{tr("No parity"), QSerialPort::NoParity}, {tr("Even parity"), QSerialPort::EvenParity},
+                           {tr("Odd parity"), QSerialPort::OddParity}}, QSerialPort::NoParity);
+  stopBitsGroup_ = addGroup({{tr("1 stop bit"), QSerialPort::OneStop}, {tr("2 stop bits"), QSerialPort::TwoStop}}, QSerialPort::TwoStop);
+}
+
 void MainWindow::on_comboBox_Mode_currentIndexChanged(int index){
     if(!comboxEnable) return;
     if(index == 1){
@@ -1,11 +1,64 @@
 #include "mainwindow.h"
+#include "e5ccsimulator.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
 #include <QLoggingCategory>
+#include <QThread>
+
+/**
+ * @brief Starts simulated E5CC controllers, each listening on its own port in its own thread.
+ * @param app The application the simulators are bound to.
+ * @param parser The parsed command line.
+ */
+static void startSimulators(QApplication &app, const QCommandLineParser &parser)
+{
+  const int count = parser.value("simulate").toInt();
+  const int port = parser.value("simulator-port").toInt();
+  E5ccSimulator::Faults faults;
+  faults.latency = parser.value("simulator-latency").toInt();
+  faults.timeoutRate = parser.value("simulator-timeout-rate").toDouble();
+  faults.exceptionRate = parser.value("simulator-exception-rate").toDouble();
+  const double timeScale = parser.value("simulator-time-scale").toDouble();
+  for (int i = 0; i < count; i++) {
+    QThread *thread = new QThread(&app);
+    E5ccSimulator *simulator = new E5ccSimulator;
+    simulator->setFaults(faults);
+    simulator->setTimeScale(timeScale);
+    simulator->moveToThread(thread);
+    QObject::connect(thread, &QThread::finished, simulator, &QObject::deleteLater);
+    QObject::connect(&app, &QApplication::aboutToQuit, thread, [thread]() {
+      thread->quit();
+      thread->wait();
+    });
+    thread->start();
+    QMetaObject::invokeMethod(simulator, [simulator, port, i]() {
+      if (simulator->start("127.0.0.1", port + i)) qDebug() << "E5CC simulator listening on tcp://127.0.0.1:" + QString::number(port + i);
+      else qWarning() << "E5CC simulator failed to listen on port" << port + i << simulator->errorString();
+    }, Qt::QueuedConnection);
+  }
+}
 
 int main(int argc, char *argv[])
 {
   QLoggingCategory::setFilterRules(QStringLiteral("qt.modbus* = true"));
   QApplication a(argc, argv);
+  a.setOrganizationName("Omron_PID");
+  a.setApplicationName("Omron_PID");
+
+  QCommandLineParser parser;
+  parser.addHelpOption();
+  parser.addOptions({
+    {"simulate", "Start <count> simulated E5CC controllers on localhost.", "count", "0"},
+    {"simulator-port", "First TCP port of the simulated controllers.", "port", "15020"},
+    {"simulator-latency", "Response latency of the simulated controllers in milliseconds.", "ms", "20"},
+    {"simulator-timeout-rate", "Probability of a response that times out.", "rate", "0"},
+    {"simulator-exception-rate", "Probability of a Modbus exception response.", "rate", "0"},
+    {"simulator-time-scale", "Simulated seconds per real second.", "factor", "1"},
+  });
+  parser.process(a);
+  startSimulators(a, parser);
+
   MainWindow w;
   w.show();
   qDebug() << "Application started.";
@@ -2,6 +2,7 @@
  *@file mainwindow.cpp
  *@brief mainwindow for connection to the E5CC
  */
+#include <QSettings>
 #include "communication.h"
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
@@ -27,11 +28,19 @@ MainWindow::MainWindow(QWidget *parent) :
   setupPlot();
   setupCombBox();
   setupDialog();
+  setupSerialMenu();
   initializeVariables();
 
-  //Generate instance to use Communication class.
+  //Generate instance to use Communication class. It runs in its own thread so that the GUI does not delay the Modbus polls.
+  comThread_ = new QThread(this);
   com_ = new Communication(this, ui->statusBar);
+  com_->moveToThread(comThread_);
+  connect(comThread_, &QThread::finished, com_, &QObject::deleteLater);
   com_->setOmronID(ui->spinBox_DeviceAddress->value());
+  com_->loadPollSettings();
+  const QSettings settings;
+  ui->actionControl_All_Devices->setChecked(settings.value("group/control", false).toBool());
+  ui->actionBroadcast_Group_Commands->setChecked(settings.value("group/broadcast", false).toBool());
   connect(com_, &Communication::TemperatureUpdated, this, &MainWindow::updateTemperature);
   connect(com_, &Communication::SVUpdated, this, &MainWindow::updateSV);
   connect(com_, &Communication::MVUpdated, this, &MainWindow::updateMV);
@@ -46,9 +55,51 @@ MainWindow::MainWindow(QWidget *parent) :
   connect(com_, &Communication::logMsg, this, &MainWindow::catchLogMsg);
   connect(com_, &Communication::logMsg, this, &MainWindow::catchLogMsgWithColor);
   connect(com_, &Communication::ATSendFinish, this, &MainWindow::finishSendAT);
+  connect(com_, &Communication::runStateChanged, this, &MainWindow::updateRunState);
+  connect(com_, &Communication::autotuningChanged, this, &MainWindow::updateAutotuning);
+  connect(com_, &Communication::sampleUpdated, this, &MainWindow::updateDeviceSample);
+  connect(com_, &Communication::gatewayChanged, this, [this](int port){
+    const QSignalBlocker blocker(ui->actionModbus_TCP_Gateway);
+    ui->actionModbus_TCP_Gateway->setChecked(port > 0);
+    ui->actionModbus_TCP_Gateway->setToolTip(port > 0 ? "Other programs reach the controllers at tcp://localhost:" + QString::number(port)
+                                                      : "Share the controllers with other programs over Modbus TCP");
+  });
   connect(com_, &Communication::SVSendFinish, this, &MainWindow::finishSendSV);
   connect(com_, &Communication::serialPortRemove, this, &MainWindow::sendLINE);
+  connect(com_, &Communication::connectionRecovered, this, [this](qint64 recoveryTime){
+    sendLINE("Connection recovered after " + QString::number(recoveryTime / 1000.0, 'f', 1) + " s. Temperature control continues.");
+  });
+  connect(com_, &Communication::serialSettingsDetected, this, [](const QString &portName, int omronID, int baudRate, int parity, int stopBits){
+    ModbusTransport::Settings settings;
+    settings.baudRate = baudRate;
+    settings.parity = parity;
+    settings.stopBits = stopBits;
+    SerialProbe::save(portName, omronID, settings);
+  });
   addPortName(com_->getSerialPortDevices());
+  diagnosticsDialog_->setStats(com_->getStats());
+  ui->comboBox_SeriesNumber->setEditable(true);
+  ui->comboBox_SeriesNumber->setToolTip(tr("Select a COM port, enter tcp://host:port for a Modbus TCP gateway, "
+                                           "or replay:file to replay a Modbus capture (replay:file?fast without its timing)"));
+  comThread_->start();
+
+  //Generate instance to use DeviceDiscovery class. The inventory of the last scan preselects the port, without a scan the ports are probed now.
+  discovery_ = new DeviceDiscovery(this);
+  connect(discovery_, &DeviceDiscovery::deviceFound, this, [this](const DeviceDiscovery::Device &device){
+    LogMsg("Found E5CC " + QString::number(device.slaveId) + " on " + device.portName + ", PV " + QString::number(device.PV)
+           + (device.responding ? "" : " (exception reply)"));
+  });
+  connect(discovery_, &DeviceDiscovery::finished, this, [this](const QList<DeviceDiscovery::Device> &devices){
+    LogMsg("Discovery finished, " + QString::number(devices.size()) + " device(s) found.");
+    applyDiscovery(devices);
+  });
+  const QList<DeviceDiscovery::Device> cached = DeviceDiscovery::loadCache();
+  if (cached.isEmpty()) {
+    LogMsg("Discovering devices...");
+    discovery_->start(QSerialPortInfo::availablePorts());
+  } else {
+    applyDiscovery(cached);
+  }
 
   //Generate instance to use DataSummary class.
   data_ = new DataSummary(com_);
@@ -58,12 +109,19 @@ MainWindow::MainWindow(QWidget *parent) :
   //Generate instance to use Safety class.
   safety_ = new Safety(data_);
   safety_->setPermitedMaxTemp(ui->spinBox_TempUpper->value());
+  com_->setSafetyLimit(ui->spinBox_TempUpper->value());
+  connect(safety_, &Safety::permitedMaxTempChanged, com_, &Communication::setSafetyLimit);
   connect(safety_, &Safety::dangerSignal, this, &MainWindow::catchDanger);
   connect(safety_, &Safety::checkNumberChanged, this, &MainWindow::updateCheckNumber);
   connect(safety_, &Safety::escapeTempCheckChange, this, &MainWindow::cathcEscapeTempCheckChange);
   connect(safety_, &Safety::startTempChangeCheck, this, &MainWindow::catchStartTempChangeCheck);
   connect(safety_, &Safety::logMsg, this, &MainWindow::catchLogMsg);
   connect(safety_, &Safety::logMsgWithColor, this, &MainWindow::catchLogMsgWithColor);
+  connect(com_, &Communication::alarmStateChanged, safety_, &Safety::setDeviceStatus);
+  connect(com_, &Communication::heaterSampled, safety_, &Safety::checkHeaterCurrent);
+  connect(com_, &Communication::HeaterCurrentUpdated, this, [this](double current){
+    ui->lineEdit_CurrentMV->setToolTip("Heater current " + QString::number(current) + " A");
+  });
 
   //Generate instance to use Notify class.
   notify_ = new Notify(this);
@@ -77,7 +135,7 @@ MainWindow::MainWindow(QWidget *parent) :
   setEnabledFalse();
 
   ui->textEdit_Log->setTextColor(QColor(34,139,34,255));
-  LogMsg("The AT and RUN/STOP do not get from the device. Please be careful.");
+  LogMsg("RUN/STOP, AT and the alarms are read from the device with every poll while running.");
   ui->textEdit_Log->setTextColor(QColor(0,0,0,255));
 
   plotTimer_ = new QTimer(this);
@@ -105,14 +163,13 @@ MainWindow::MainWindow(QWidget *parent) :
  */
 MainWindow::~MainWindow()
 {
-    auto omron = com_->getOmron();
-    if (omron) omron->disconnectDevice();
+    comThread_->quit();
+    comThread_->wait();
     clock->stop();
     waitTimer->stop();
     delete waitTimer;
     delete clock;
     delete plot;
-    delete omron;
     delete ui;
 }
 
@@ -231,21 +288,15 @@ void MainWindow::on_pushButton_AskStatus_clicked(){
 /**
  * @brief Retrieves the settings from the device.
  *
- * This function sends requests to the communication object `com_` to retrieve the temperature,
- * SV (Set Value), MV (Manipulated Value), MV upper limit, MV lower limit, and PID values from the device.
- * It sets the `spinBoxEnable` flag to `false` before requesting the MV upper and lower limits to prevent
- * the associated spin boxes from being updated. After that, it sets the `spinBoxEnable` flag back to `true`
- * and requests the PID values from the device.
+ * This function asks the communication object `com_` to read all registers of the device into its
+ * configuration snapshot with a few block reads. The temperature, SV (Set Value), MV (Manipulated Value),
+ * MV upper limit, MV lower limit, and PID values arrive asynchronously through the Updated signals. The spin boxes of the MV upper and lower limits
+ * are updated by updateMVupper() and updateMVlower(), which suppress the write back to the device.
+ * Finally the `spinBoxEnable` flag is set to `true` so that user changes are sent to the device.
  */
 void MainWindow::getSetting(){
-  com_->askTemperature();
-  com_->askSV();
-  com_->askMV();
-  spinBoxEnable = false;
-  com_->askMVupper();
-  com_->askMVlower();
+  com_->askSetting();
   spinBoxEnable = true;
-  com_->askPID("PID");
 }
 
 /**
@@ -519,12 +570,38 @@ void MainWindow::on_comboBox_AT_currentIndexChanged(int index)
 /**
  * @brief Slot triggered when the "Connect" button is clicked.
  *
- * This slot is called when the "Connect" button is clicked.
+ * This slot is called when the "Connect" button is clicked. A typed "tcp://host:port"
+ * endpoint connects through a Modbus TCP gateway instead of the selected COM port.
  */
 void MainWindow::on_pushButton_Connect_clicked(){
+  if (discovery_->isRunning()) {
+    discovery_->stop();
+    LogMsg("Discovery stopped.");
+  }
   LogMsg("Start connecing...");
   LogMsg("Please do nothing and wait for a moment.");
-  com_->setSerialPortName(ui->comboBox_SeriesNumber->currentData().toString());
+  const QString endpoint = ui->comboBox_SeriesNumber->currentText().trimmed();
+  const int omronID = ui->spinBox_DeviceAddress->value();
+  if (endpoint.startsWith("tcp://") || endpoint.startsWith("replay:")) {
+    com_->setSerialPortName(endpoint);
+  } else {
+    // Auto-detect starts with the settings stored for the device, a fixed choice is stored for it.
+    const QString portName = ui->comboBox_SeriesNumber->currentData().toString();
+    com_->setSerialPortName(portName);
+    ModbusTransport::Settings serial;
+    serial.baudRate = baudGroup_->checkedAction()->data().toInt();
+    serial.parity = parityGroup_->checkedAction()->data().toInt();
+    serial.stopBits = stopBitsGroup_->checkedAction()->data().toInt();
+    const bool autoProbe = serial.baudRate == 0;
+    if (autoProbe) {
+      if (!SerialProbe::load(portName, omronID, serial)) serial.baudRate = QSerialPort::Baud9600;
+    } else {
+      SerialProbe::save(portName, omronID, serial);
+    }
+    com_->setSerialSettings(serial.baudRate, serial.parity, serial.stopBits);
+    com_->setAutoProbe(autoProbe);
+  }
+  com_->setOmronID(omronID);
   com_->executeConnection();
   LogMsg("Finish connecing.");
 }
@@ -558,7 +635,7 @@ void MainWindow::on_doubleSpinBox_MVupper_valueChanged(double arg1){
     com_->changeMVupperValue(arg1);
     safety_->setMVUpper(arg1);
     LogMsg("Output upper limit is set to be " + QString::number(arg1));
-    plot->yAxis2->setRangeLower(com_->getMVupper() + 2);
+    plot->yAxis2->setRangeLower(arg1 + 2);
     plot->replot();
 }
 
@@ -574,7 +651,8 @@ void MainWindow::on_pushButton_GetPID_clicked() {com_->askPID("PID");}
  * @brief Slot triggered when the current text of the memory address combo box is changed.
  *
  * This slot is called when the user selects a different memory address from the combo box (comboBox_MemAddress).
- * It reads the selected memory address using the communication object (com_) and logs a message indicating the read operation.
+ * It logs the value of the selected memory address from the configuration snapshot of the communication object (com_)
+ * together with the time it was read. An address that is not in the snapshot yet is read from the device.
  *
  * @param arg1 The current text of the memory address combo box.
  */
@@ -583,6 +661,12 @@ void MainWindow::on_comboBox_MemAddress_currentTextChanged(const QString &arg1)
     if(!comboxEnable) return;
     quint16 address = ui->comboBox_MemAddress->currentData().toUInt();
     LogMsg("--------- read " + arg1);
+    const ConfigSnapshot::Entry entry = com_->getSnapshot()->entry(com_->getOmronID(), address);
+    if (entry.valid) {
+      LogMsg(QString("Value: %1 (raw %2, read at %3)").arg(entry.value).arg(entry.raw)
+             .arg(entry.read.toString("hh:mm:ss")));
+      return;
+    }
     com_->read(QModbusDataUnit::HoldingRegisters, address, 2);
 }
 
@@ -725,6 +809,92 @@ void MainWindow::on_actionHelp_Page_triggered(){
     if( helpDialog_->isHidden() ) helpDialog_->show();
 }
 
+/**
+ * @brief Shows the Modbus diagnostics dialog if it is hidden.
+ */
+void MainWindow::on_actionModbus_Diagnostics_triggered(){
+    if( diagnosticsDialog_->isHidden() ) diagnosticsDialog_->show();
+}
+
+/**
+ * @brief Probes all serial ports for E5CC controllers. The ports must not be in use.
+ */
+void MainWindow::on_actionDiscover_Devices_triggered(){
+  if (!ui->pushButton_Connect->isEnabled()) {
+    QMessageBox msgbox;
+    msgbox.setIcon(QMessageBox::Warning);
+    msgbox.setText(tr("Cannot discover devices while connected."));
+    msgbox.setWindowTitle(tr("Warning"));
+    msgbox.setStandardButtons(QMessageBox::Ok);
+    msgbox.exec();
+    return;
+  }
+  if (discovery_->isRunning()) return;
+  LogMsg("Discovering devices...");
+  discovery_->start(QSerialPortInfo::availablePorts());
+}
+
+/**
+ * @brief Starts or stops writing every Modbus transaction to a capture file.
+ *
+ * The capture can be replayed later by connecting to "replay:" followed by the path of the file.
+ *
+ * @param checked true to start a capture, false to stop it.
+ */
+void MainWindow::on_actionRecord_Modbus_Capture_toggled(bool checked){
+  if (!checked) {
+    com_->stopCapture();
+    LogMsg("Modbus capture stopped.");
+    return;
+  }
+  const QString fileName = QFileDialog::getSaveFileName(this, tr("Record Modbus Capture"), filePath_, tr("Modbus capture (*.omcf)"));
+  if (fileName.isEmpty() || !com_->startCapture(fileName)) {
+    if (!fileName.isEmpty()) LogMsg("Cannot write the Modbus capture " + fileName);
+    const QSignalBlocker blocker(ui->actionRecord_Modbus_Capture);
+    ui->actionRecord_Modbus_Capture->setChecked(false);
+    return;
+  }
+  LogMsg("Recording Modbus capture to " + fileName);
+}
+
+/**
+ * @brief Opens or closes the local Modbus TCP gateway.
+ *
+ * While the gateway is open, other programs on this computer read the controllers through
+ * tcp://localhost:1502 and are answered from the values of the running poll where possible.
+ *
+ * @param checked true to open the gateway, false to close it.
+ */
+void MainWindow::on_actionModbus_TCP_Gateway_toggled(bool checked){
+  com_->setGateway(checked ? ModbusGateway::portDefault : 0);
+}
+
+/**
+ * @brief Sends Run, Stop and the set value to all polled controllers or to the selected one only.
+ *
+ * The polled controllers are the selected one and the other controllers of the discovery inventory on
+ * the connected port. The choice is kept in the settings.
+ *
+ * @param checked true to control all polled controllers.
+ */
+void MainWindow::on_actionControl_All_Devices_toggled(bool checked){
+  com_->setGroupControl(checked);
+  QSettings().setValue("group/control", checked);
+}
+
+/**
+ * @brief Allows group commands to be sent as one broadcast to slave address 0.
+ *
+ * A broadcast is used only when the group covers every polled controller, as it reaches every device
+ * on the line. The choice is kept in the settings.
+ *
+ * @param checked true to allow broadcasts.
+ */
+void MainWindow::on_actionBroadcast_Group_Commands_toggled(bool checked){
+  com_->setBroadcastWrites(checked);
+  QSettings().setValue("group/broadcast", checked);
+}
+
 /**
  * @brief Shows the plot dialog if it is hidden.
  */
@@ -1153,6 +1323,63 @@ void MainWindow::addPortName(QList<QSerialPortInfo> info){
     LogMsg ("--------------");
 }
 
+/**
+ * @brief Preselects the COM port and the device address of the first controller found.
+ *
+ * The slave addresses of all controllers on that port are shown as the tooltip of the device address.
+ * Nothing is changed while connected.
+ *
+ * @param devices The inventory of a scan or of the cache.
+ */
+void MainWindow::applyDiscovery(const QList<DeviceDiscovery::Device> &devices){
+  if (devices.isEmpty() || !ui->pushButton_Connect->isEnabled()) return;
+  const DeviceDiscovery::Device &first = devices.first();
+  const int index = ui->comboBox_SeriesNumber->findData(first.portName);
+  if (index < 0) return;
+  ui->comboBox_SeriesNumber->setCurrentIndex(index);
+  ui->spinBox_DeviceAddress->setValue(first.slaveId);
+  QStringList ids;
+  for (const DeviceDiscovery::Device &device : devices) {
+    if (device.portName == first.portName) ids << QString::number(device.slaveId);
+  }
+  ui->spinBox_DeviceAddress->setToolTip(tr("Devices on %1: %2").arg(first.portName, ids.join(", ")));
+}
+
+/**
+ * @brief Adds the other controllers on the connected port to the status poll.
+ *
+ * The controllers are taken from the inventory of the last discovery. The selected controller is polled
+ * anyway, and a controller that only answered with an exception is left out.
+ */
+void MainWindow::pollDiscovered(){
+  QStringList ids;
+  for (const DeviceDiscovery::Device &device : DeviceDiscovery::loadCache()) {
+    if (device.portName != com_->getPortName() || device.slaveId == com_->getOmronID() || !device.responding) continue;
+    com_->addPollDevice(device.slaveId);
+    ids << QString::number(device.slaveId);
+  }
+  if (!ids.isEmpty()) LogMsg("Also polling the controllers " + ids.join(", ") + " on " + com_->getPortName() + ".");
+}
+
+/**
+ * @brief Shows the values of the other polled controllers.
+ *
+ * The selected controller is shown in the main panel. The last values of every other polled controller
+ * are listed in the tooltip of the device address.
+ *
+ * @param sample The sample of a poll.
+ */
+void MainWindow::updateDeviceSample(const DeviceSample &sample){
+  if (sample.omronID == com_->getOmronID()) return;
+  deviceSamples_.insert(sample.omronID, sample);
+  QStringList lines;
+  for (const DeviceSample &device : qAsConst(deviceSamples_)) {
+    lines << QString::number(device.omronID) + ": " + (device.valid ? "PV " + QString::number(device.temperature) + " C, SV "
+                                                                      + QString::number(device.SV) + " C, MV " + QString::number(device.MV) + " %"
+                                                                    : QString("no reply"));
+  }
+  ui->spinBox_DeviceAddress->setToolTip("Other controllers\n" + lines.join("\n"));
+}
 
 /**
  * @brief Updates the displayed temperature value.
@@ -1194,12 +1421,16 @@ void MainWindow::updateSV(double SV){
  * @brief Updates the upper range of the manipulated variable (MV) and the corresponding plot range.
  *
  * This function is a slot that is connected to the MV upper range update signal. It updates the upper range
- * of the MV in the user interface and adjusts the plot range accordingly.
+ * of the MV in the user interface and adjusts the plot range accordingly. The value read from the device
+ * is not written back to it.
  *
  * @param MVupper The new upper range of the MV.
  */
 void MainWindow::updateMVupper(double MVupper){
+  const bool enable = spinBoxEnable;
+  spinBoxEnable = false;
   ui->doubleSpinBox_MVupper->setValue(MVupper);
+  spinBoxEnable = enable;
   plot->yAxis2->setRangeUpper(MVupper + 2);
   plot->replot();
 }
@@ -1208,12 +1439,16 @@ void MainWindow::updateMVupper(double MVupper){
  * @brief Updates the lower range of the manipulated variable (MV).
  *
  * This function is a slot that is connected to the MV lower range update signal. It updates the lower range
- * of the MV in the user interface with the provided MV lower value.
+ * of the MV in the user interface with the provided MV lower value. The value read from the device
+ * is not written back to it.
  *
  * @param MVlower The new lower range of the MV.
  */
 void MainWindow::updateMVlower(double MVlower){
+  const bool enable = spinBoxEnable;
+  spinBoxEnable = false;
   ui->doubleSpinBox_MVlower->setValue(MVlower);
+  spinBoxEnable = enable;
 }
 
 /**
@@ -1326,8 +1561,13 @@ void MainWindow::connectDevice(){
   ui->lineEdit_SV2->setEnabled(false);
   QString title = this->windowTitle();
   this->setWindowTitle(title + " | " + ui->comboBox_SeriesNumber->currentText());
+  auto initialSV = QSharedPointer<QMetaObject::Connection>::create();
+  *initialSV = connect(com_, &Communication::SVUpdated, this, [this, initialSV](double SV){
+    ui->lineEdit_SV->setText(QString::number(SV));
+    disconnect(*initialSV);
+  });
+  pollDiscovered();
   getSetting();
-  ui->lineEdit_SV->setText(QString::number(data_->getSV()));
   LogMsg("Set Stop.");
   QColor color = QColor("palegray");
   QPalette pal = palette();
@@ -1376,6 +1616,55 @@ void MainWindow::finishSendAT(int atFlag){
   }
 }
 
+/**
+ * @brief Follows the run state polled from the device.
+ *
+ * This function is called when the run state of the controller changes on the device, e.g. because it was
+ * stopped on the front panel or lost power. A state that differs from the "Run/Stop" button is logged in red
+ * and reported via LINE. The button follows the device without sending a command. A controller that stopped
+ * by itself also stops the safety module, as there is no output left to watch.
+ *
+ * @param running true if the controller is running.
+ */
+void MainWindow::updateRunState(bool running){
+  if (ui->pushButton_RunStop->isChecked() == running) return;
+  ui->textEdit_Log->setTextColor(QColor(255,0,0,255));
+  LogMsg(running ? "The controller is running, although it was not started here."
+                 : "The controller has stopped, although it was not stopped here.");
+  ui->textEdit_Log->setTextColor(QColor(0,0,0,255));
+  sendLINE(running ? "The controller was started on the device." : "The controller stopped on the device.");
+  const QSignalBlocker blocker(ui->pushButton_RunStop);
+  ui->pushButton_RunStop->setChecked(running);
+  ui->pushButton_RunStop->setText(running ? "Stop" : "Run");
+  ui->checkBoxStatusRun->setChecked(running);
+  if (!running) {
+    safety_->stop();
+    setColor(0);
+  }
+}
+
+/**
+ * @brief Follows the autotuning state polled from the device.
+ *
+ * This function is called when the autotuning starts or ends on the device. When it has ended, the AT
+ * selection returns to none and the Set Point is enabled again, as finishSendAT() does for a cancel.
+ *
+ * @param running true while the controller executes the autotuning.
+ */
+void MainWindow::updateAutotuning(bool running){
+  if (running == (ui->comboBox_AT->currentIndex() != 0)) return;
+  ui->lineEdit_SV->setEnabled(!running);
+  ui->pushButton_SetSV->setEnabled(!running);
+  if (running) {
+    LogMsg("AT is running on the device, disable Set Point.");
+    return;
+  }
+  comboxEnable = false;
+  ui->comboBox_AT->setCurrentIndex(0);
+  comboxEnable = true;
+  LogMsg("AT has finished on the device.");
+}
+
 /**
  * @brief Handles the completion of setting the target temperature (SV).
  *
@@ -1420,6 +1709,15 @@ void MainWindow::catchDanger(int type){
     case 3 :
       LogMsg("Temperature continued to drop for some intervals.");
       break;
+    case 4 :
+      LogMsg("The controller reports a heater burnout.");
+      break;
+    case 5 :
+      LogMsg("The controller reports an input error. Check the sensor.");
+      break;
+    case 6 :
+      LogMsg("The output is on, but almost no heater current flows. Check the heater and the SSR.");
+      break;
     default :
       LogMsg("Danger Signal is detectived.");
       break;
@@ -1527,7 +1825,6 @@ void MainWindow::updateStatusBoxes(){
   bool is_update_running = com_->isTimerUpdateRunning();
   ui->checkBoxUpdate->setChecked(is_update_running);
   bool is_run = ui->pushButton_RunStop->isChecked();
-  LogMsg(QString::number(isQuit_));
 
   if (isQuit_) {
       setColor(3);
@@ -15,6 +15,7 @@
 #include <QScrollBar>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QThread>
 #include <QImage>
 #include <qcustomplot.h>
 #include <QElapsedTimer>
@@ -24,15 +25,19 @@
 #include <QHBoxLayout>
 #include <QFile>
 #include <QGraphicsView>
+#include <QActionGroup>
 #include <QTextStream>
 #include <QSslSocket>
 #include "configuredialog.h"
 #include "plotdialog.h"
 #include "tempdropdialog.h"
 #include "helpdialog.h"
+#include "diagnosticsdialog.h"
 #include "joinlinedialog.h"
 #include "notify.h"
 #include "datasummary.h"
+#include "devicediscovery.h"
+#include "serialprobe.h"
 
 /**
  * @brief The MainWindow class represents the main window of the application.
@@ -143,6 +148,24 @@ public slots:
   */
   void finishSendAT(int atFlag);
 
+  /**
+  @brief updateRunState Slot function to follow the run state polled from the device
+  @param running true if the controller is running
+  */
+  void updateRunState(bool running);
+
+  /**
+  @brief updateAutotuning Slot function to follow the autotuning state polled from the device
+  @param running true while the controller executes the autotuning
+  */
+  void updateAutotuning(bool running);
+
+  /**
+  @brief updateDeviceSample Slot function to show the values of the other polled controllers
+  @param sample The sample of a poll
+  */
+  void updateDeviceSample(const DeviceSample &sample);
+
   /**
   @brief finishSendSV Slot function to handle the completion of sending the set value (SV) to the device
   @param SV The set value that was sent
@@ -257,6 +280,12 @@ private slots:
     void on_action_Setting_parameters_for_TempCheck_triggered();
     void on_action_Setting_plot_triggered();
     void on_actionHelp_Page_triggered();
+    void on_actionModbus_Diagnostics_triggered();
+    void on_actionDiscover_Devices_triggered();
+    void on_actionRecord_Modbus_Capture_toggled(bool checked);
+    void on_actionModbus_TCP_Gateway_toggled(bool checked);
+    void on_actionControl_All_Devices_toggled(bool checked);
+    void on_actionBroadcast_Group_Commands_toggled(bool checked);
     void on_action_JoinLINE_RIKEN_triggered();
     void on_action_JoinLINE_Kyushu_triggered();
     void fillDataAndPlot(const QDateTime date, const double PV, const double SV, const double MV);
@@ -289,10 +318,16 @@ private:
     Ui::MainWindow *ui;                            ///< Pointer to the MainWindow UI object
     QCustomPlot *plot{nullptr};                     ///< Pointer to the QCustomPlot object
     Communication *com_{nullptr};                   ///< Pointer to the Communication object
+    QThread *comThread_{nullptr};                   ///< Thread the Communication object runs in
     Safety *safety_{nullptr};                       ///< Pointer to the Safety object
     Notify *notify_{nullptr};                       ///< Pointer to the Notify object
     DataSummary *data_{nullptr};                    ///< Pointer to the DataSummary object
     HelpDialog *helpDialog_{nullptr};               ///< Pointer to the HelpDialog object
+    DiagnosticsDialog *diagnosticsDialog_{nullptr}; ///< Pointer to the DiagnosticsDialog object
+    DeviceDiscovery *discovery_{nullptr};           ///< Pointer to the DeviceDiscovery object
+    QActionGroup *baudGroup_{nullptr};              ///< Baud rate choices, 0 for auto-detect
+    QActionGroup *parityGroup_{nullptr};            ///< Parity choices
+    QActionGroup *stopBitsGroup_{nullptr};          ///< Stop bit choices
     QGraphicsScene *scene_{nullptr};                ///< Pointer to the QGraphicsScene object
     QGraphicsView *view{nullptr};                   ///< Pointer to the QGraphicsView object
     PlotDialog *plotDialog_{nullptr};               ///< Pointer to the PlotDialog object
@@ -328,9 +363,21 @@ private:
     int dayCounter{};                                ///< Counter for days
     bool bkgColorChangeable_{true};                  ///< Flag indicating the changeability of background color
     bool isQuit_{false};                             ///< Flag indicating the quit state
+    QMap<int, DeviceSample> deviceSamples_{};        ///< Last sample of each other polled controller
 
     // Private functions
     void addPortName(QList<QSerialPortInfo> info);                          ///< Function to add port names
+
+    /**
+    * @brief applyDiscovery Preselects the port and the slave address of the first controller found.
+    * @param devices The inventory of a scan or of the cache.
+    */
+    void applyDiscovery(const QList<DeviceDiscovery::Device> &devices);
+
+    /**
+    * @brief pollDiscovered Adds the other controllers of the inventory on the connected port to the status poll.
+    */
+    void pollDiscovered();
     void setupPlot();                                                      ///< Function to setup the plot
 
     /**
@@ -348,6 +395,11 @@ private:
      */
     void setupDialog();
 
+    /**
+     * @brief setupSerialMenu Adds the baud rate, parity and stop bit choices to the Configure menu.
+     */
+    void setupSerialMenu();
+
     /**
      * @brief initializeVariables Initializes the variables.
      */
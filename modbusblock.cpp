@@ -0,0 +1,41 @@
+#include <algorithm>
+#include "modbusblock.h"
+
+bool ModbusBlock::contains(quint16 address) const {
+  return address >= start && address + width <= end();
+}
+
+qint32 ModbusBlock::doubleWord(const QVector<quint16> &values, quint16 address) const {
+  const int offset = address - start;
+  if (offset < 0 || offset + 1 >= values.size()) return 0;
+  const quint32 upper = values.at(offset);
+  const quint32 lower = values.at(offset + 1);
+  return static_cast<qint32>((upper << 16) | lower);
+}
+
+/**
+ * @details Each variable occupies ModbusBlock::width registers. A new window is opened
+ * whenever the next variable would leave a gap larger than @p maxGap or would make the
+ * current window longer than @p maxCount registers.
+ */
+QVector<ModbusBlock> ModbusBlock::plan(QVector<quint16> addresses, int maxGap, int maxCount){
+  QVector<ModbusBlock> blocks;
+  std::sort(addresses.begin(), addresses.end());
+  addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+  for (const quint16 address : qAsConst(addresses)) {
+    if (!blocks.isEmpty()) {
+      ModbusBlock &last = blocks.last();
+      const int gap = address - last.end();
+      const int count = address + width - last.start;
+      if (gap <= maxGap && count <= maxCount) {
+        if (address + width > last.end()) last.count = static_cast<quint16>(count);
+        continue;
+      }
+    }
+    ModbusBlock block;
+    block.start = address;
+    block.count = width;
+    blocks.append(block);
+  }
+  return blocks;
+}
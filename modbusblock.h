@@ -0,0 +1,70 @@
+/**
+ * @file modbusblock.h
+ * @brief Declaration of the ModbusBlock struct used to coalesce register reads.
+ */
+
+#ifndef MODBUSBLOCK_H
+#define MODBUSBLOCK_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @brief The ModbusBlock struct describes one contiguous window of holding registers
+ * that is fetched with a single ReadHoldingRegisters request.
+ *
+ * The E5CC exposes every variable as a double word (two 16 bit registers, upper word first),
+ * so neighbouring variables can be read together and all of them decoded from one reply.
+ */
+struct ModbusBlock
+{
+  /**
+   * @brief The limits enumeration defines the default window layout.
+   */
+  enum limits {
+    width = 2, /**< Number of registers of one E5CC variable */
+    maxGapDefault = 8, /**< Unused registers that may be read along to join two variables */
+    maxCountDefault = 50 /**< Number of registers the E5CC accepts in one read */
+  };
+
+  quint16 start{}; /**< First register address of the window */
+  quint16 count{}; /**< Number of 16 bit registers in the window */
+
+  /**
+   * @brief Returns the address just behind the last register of the window.
+   */
+  int end() const {return start + count;}
+
+  /**
+   * @brief Checks whether the variable at the given address is covered by the window.
+   * @param address The start address of the variable.
+   * @return true if all registers of the variable lie inside the window.
+   */
+  bool contains(quint16 address) const;
+
+  /**
+   * @brief Decodes the signed double word stored at the given address.
+   * @param values The register values returned for this window.
+   * @param address The start address of the variable. It must be covered by the window.
+   * @return The signed 32 bit value of the variable.
+   */
+  qint32 doubleWord(const QVector<quint16> &values, quint16 address) const;
+
+  /**
+   * @brief Groups variable addresses into as few contiguous windows as possible.
+   *
+   * The addresses are sorted and merged into one window as long as the gap between two
+   * variables does not exceed @p maxGap registers and the window does not grow beyond
+   * @p maxCount registers.
+   *
+   * @param addresses Start addresses of the double word variables to read.
+   * @param maxGap Largest number of unused registers allowed inside a window.
+   * @param maxCount Largest number of registers in one window.
+   * @return The windows sorted by their start address.
+   */
+  static QVector<ModbusBlock> plan(QVector<quint16> addresses,
+                                   int maxGap = maxGapDefault,
+                                   int maxCount = maxCountDefault);
+};
+
+#endif // MODBUSBLOCK_H
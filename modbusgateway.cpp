@@ -0,0 +1,195 @@
+#include <QDataStream>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "modbusgateway.h"
+#include "configsnapshot.h"
+#include "e5ccregisters.h"
+#include "modbusqueue.h"
+
+ModbusGateway::ModbusGateway(ModbusQueue *queue, ConfigSnapshot *snapshot, QObject *parent)
+  : QObject(parent), queue_(queue), snapshot_(snapshot)
+{
+  server_ = new QTcpServer(this);
+  connect(server_, &QTcpServer::newConnection, this, &ModbusGateway::acceptClients);
+}
+
+bool ModbusGateway::listen(quint16 port, const QHostAddress &address){
+  close();
+  return server_->listen(address, port);
+}
+
+void ModbusGateway::close(){
+  server_->close();
+  const QList<QTcpSocket*> sockets = buffers_.keys();
+  for (QTcpSocket *socket : sockets) socket->abort();
+}
+
+void ModbusGateway::acceptClients(){
+  while (server_->hasPendingConnections()) {
+    QTcpSocket *socket = server_->nextPendingConnection();
+    buffers_.insert(socket, QByteArray());
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {readClient(socket);});
+    connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+      buffers_.remove(socket);
+      socket->deleteLater();
+      emit clientCountChanged(buffers_.size());
+    });
+    emit clientCountChanged(buffers_.size());
+  }
+}
+
+/**
+ * @details A frame is the MBAP header of seven bytes followed by the PDU without its unit byte.
+ * A header with a protocol identifier other than 0 or an impossible length means the client
+ * does not speak Modbus TCP, and the connection is dropped.
+ */
+void ModbusGateway::readClient(QTcpSocket *socket){
+  QByteArray &buffer = buffers_[socket];
+  buffer.append(socket->readAll());
+  while (buffer.size() >= 8) {
+    QDataStream stream(buffer);
+    quint16 transaction = 0;
+    quint16 protocol = 0;
+    quint16 length = 0;
+    quint8 unit = 0;
+    quint8 code = 0;
+    stream >> transaction >> protocol >> length >> unit >> code;
+    if (protocol != 0 || length < 2 || length + 6 > maxFrame) {
+      socket->abort();
+      return;
+    }
+    if (buffer.size() < length + 6) return;
+    const QModbusRequest request(static_cast<QModbusPdu::FunctionCode>(code), buffer.mid(8, length - 2));
+    buffer.remove(0, length + 6);
+    handle(socket, transaction, unit, request);
+  }
+}
+
+void ModbusGateway::handle(QTcpSocket *socket, quint16 transaction, quint8 unit, const QModbusRequest &request){
+  const int serverAddress = (unit == 0 || unit == 0xFF) ? defaultServer() : unit;
+  const QByteArray data = request.data();
+  const quint16 start = data.size() >= 2 ? static_cast<quint16>((quint8(data.at(0)) << 8) | quint8(data.at(1))) : 0;
+  const int count = data.size() >= 4 ? ((quint8(data.at(2)) << 8) | quint8(data.at(3))) : 0;
+  if (request.functionCode() == QModbusPdu::ReadHoldingRegisters && count >= 1 && count <= 125) {
+    QVector<quint16> values;
+    if (readCache(serverAddress, start, count, values)) {
+      QByteArray payload;
+      QDataStream stream(&payload, QIODevice::WriteOnly);
+      stream << static_cast<quint8>(values.size() * 2);
+      for (const quint16 value : values) stream << value;
+      mutex_.lock();
+      cacheHits_++;
+      mutex_.unlock();
+      reply(socket, transaction, unit, QModbusResponse(request.functionCode(), payload));
+      return;
+    }
+  }
+  quint16 writeStart = start;
+  QVector<quint16> writeValues;
+  ModbusQueue::Lane lane = ModbusQueue::Lane::Low;
+  switch (request.functionCode()) {
+    case QModbusPdu::ReadHoldingRegisters:
+    case QModbusPdu::ReadInputRegisters:
+    case QModbusPdu::Diagnostics:
+      break;
+    case QModbusPdu::WriteSingleRegister:
+      writeValues = words(data, 2, 1);
+      lane = ModbusQueue::Lane::High;
+      break;
+    case QModbusPdu::WriteMultipleRegisters:
+      writeValues = words(data, 5, count);
+      lane = ModbusQueue::Lane::High;
+      break;
+    case QModbusPdu::ReadWriteMultipleRegisters:
+      if (data.size() >= 8) {
+        writeStart = static_cast<quint16>((quint8(data.at(4)) << 8) | quint8(data.at(5)));
+        writeValues = words(data, 9, (quint8(data.at(6)) << 8) | quint8(data.at(7)));
+      }
+      break;
+    default:
+      reply(socket, transaction, unit, QModbusExceptionResponse(request.functionCode(), QModbusExceptionResponse::IllegalFunction));
+      return;
+  }
+  QPointer<QTcpSocket> client(socket);
+  const bool queued = queue_->enqueue(request, serverAddress, [this, client, transaction, unit, serverAddress, writeStart, writeValues](const ModbusResult &result) {
+    if (result.isValid()) {
+      const QVector<quint16> values = result.values();
+      if (!values.isEmpty()) snapshot_->update(serverAddress, result.startAddress(), values);
+      if (!writeValues.isEmpty()) emit written(serverAddress, writeStart, writeValues);
+    }
+    if (!client) return;
+    if (result.isValid() || result.response.isException()) {
+      reply(client, transaction, unit, result.response);
+    } else if (result.error == QModbusDevice::ReplyAbortedError) {
+      reply(client, transaction, unit, QModbusExceptionResponse(result.request.functionCode(), QModbusExceptionResponse::ServerDeviceBusy));
+    } else if (result.error == QModbusDevice::TimeoutError) {
+      reply(client, transaction, unit, QModbusExceptionResponse(result.request.functionCode(), QModbusExceptionResponse::GatewayTargetDeviceFailedToRespond));
+    } else {
+      reply(client, transaction, unit, QModbusExceptionResponse(result.request.functionCode(), QModbusExceptionResponse::GatewayPathUnavailable));
+    }
+  }, lane);
+  if (!queued) return;
+  QMutexLocker locker(&mutex_);
+  forwarded_++;
+}
+
+/**
+ * @details Every E5CC variable is a double word with the upper word first, so an odd address is
+ * the lower word of the variable before it. The snapshot stores the registers of one reply
+ * together, so a range read within one block of the status poll is as coherent as that block.
+ */
+bool ModbusGateway::readCache(int serverAddress, quint16 start, int count, QVector<quint16> &values) const {
+  const int age = maxAge();
+  if (age <= 0) return false;
+  const QDateTime oldest = QDateTime::currentDateTime().addMSecs(-age);
+  values.clear();
+  for (int i = 0; i < count; i++) {
+    const quint16 address = static_cast<quint16>(start + i);
+    quint16 variable = address;
+    bool lower = false;
+    if (!E5ccRegisters::find(address)) {
+      variable = static_cast<quint16>(address - 1);
+      lower = true;
+      if (address == 0 || !E5ccRegisters::find(variable)) return false;
+    }
+    const ConfigSnapshot::Entry entry = snapshot_->entry(serverAddress, variable);
+    if (!entry.valid || entry.read < oldest) return false;
+    const quint32 raw = static_cast<quint32>(entry.raw);
+    values.append(static_cast<quint16>(lower ? (raw & 0xFFFF) : (raw >> 16)));
+  }
+  return true;
+}
+
+QVector<quint16> ModbusGateway::words(const QByteArray &data, int offset, int count){
+  QVector<quint16> values;
+  if (count <= 0 || data.size() < offset + 2 * count) return values;
+  for (int i = 0; i < count; i++) {
+    values.append(static_cast<quint16>((quint8(data.at(offset + 2 * i)) << 8) | quint8(data.at(offset + 2 * i + 1))));
+  }
+  return values;
+}
+
+void ModbusGateway::reply(QTcpSocket *socket, quint16 transaction, quint8 unit, const QModbusPdu &pdu){
+  QByteArray frame;
+  QDataStream stream(&frame, QIODevice::WriteOnly);
+  const QByteArray payload = pdu.data();
+  quint8 code = static_cast<quint8>(pdu.functionCode());
+  if (pdu.isException()) code |= QModbusPdu::ExceptionByte;
+  stream << transaction << static_cast<quint16>(0) << static_cast<quint16>(payload.size() + 2) << unit << code;
+  frame.append(payload);
+  socket->write(frame);
+}
+
+bool ModbusGateway::isListening() const {return server_->isListening();}
+quint16 ModbusGateway::port() const {return server_->serverPort();}
+QString ModbusGateway::errorString() const {return server_->errorString();}
+int ModbusGateway::clientCount() const {return buffers_.size();}
+void ModbusGateway::setDefaultServer(int serverAddress){QMutexLocker locker(&mutex_); defaultServer_ = serverAddress;}
+int ModbusGateway::defaultServer() const {QMutexLocker locker(&mutex_); return defaultServer_;}
+void ModbusGateway::setMaxAge(int maxAge){QMutexLocker locker(&mutex_); maxAge_ = qMax(0, maxAge);}
+int ModbusGateway::maxAge() const {QMutexLocker locker(&mutex_); return maxAge_;}
+quint64 ModbusGateway::cacheHits() const {QMutexLocker locker(&mutex_); return cacheHits_;}
+quint64 ModbusGateway::forwarded() const {QMutexLocker locker(&mutex_); return forwarded_;}
@@ -0,0 +1,158 @@
+/**
+ * @file modbusgateway.h
+ * @brief Declaration of the ModbusGateway class, a local Modbus TCP server in front of the serial bus.
+ */
+
+#ifndef MODBUSGATEWAY_H
+#define MODBUSGATEWAY_H
+
+#include <QHash>
+#include <QHostAddress>
+#include <QModbusPdu>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+class ConfigSnapshot;
+class ModbusQueue;
+class QTcpServer;
+class QTcpSocket;
+
+/**
+ * @brief The ModbusGateway class lets other programs share the controllers on the serial line.
+ *
+ * Local clients connect with Modbus TCP. A ReadHoldingRegisters request is answered from the
+ * ConfigSnapshot when every register it covers has been read within maxAge(). The status poll
+ * keeps PV, status, heater current and MV fresh, so several viewers watching the same values
+ * add no traffic to the bus. A read the cache cannot answer is sent in the low lane of the
+ * ModbusQueue. Its reply also updates the snapshot, so the next client reading the same range
+ * is served from the cache. WriteSingleRegister and WriteMultipleRegisters are sent in the high
+ * lane, in order with the commands of the application; ReadWriteMultipleRegisters and Diagnostics
+ * go to the low lane, so a client cannot crowd the status poll out of the high lane. Every other
+ * function code is refused locally with IllegalFunction and never reaches the serial line. The
+ * reply of the controller, exceptions included, is returned to the client. An accepted write is
+ * reported with written(), so the owner can bring the cache up to date before the next read is
+ * answered from it.
+ *
+ * The unit identifiers 0 and 255, which Modbus TCP clients use for the gateway itself, address
+ * the default server. If the bus is not connected, the gateway answers with exception 0x0A
+ * (gateway path unavailable). If the controller does not answer, it returns exception 0x0B
+ * (target device failed to respond), and to a request the full queue has refused with exception
+ * 0x06 (server device busy). The gateway must live in the thread of the queue.
+ */
+class ModbusGateway : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * @brief The limits enumeration defines the defaults of the gateway.
+   */
+  enum limits {
+    portDefault = 1502, /**< TCP port, 502 needs administrator rights on most systems */
+    maxAgeDefault = 5000, /**< Age in ms up to which a cached register answers a read */
+    maxFrame = 260 /**< Largest Modbus TCP frame, MBAP header included */
+  };
+
+  /**
+   * @brief Constructs a closed gateway.
+   * @param queue The queue the requests are sent with. The gateway does not take ownership.
+   * @param snapshot The register cache reads are answered from. The gateway does not take ownership.
+   * @param parent The parent object.
+   */
+  ModbusGateway(ModbusQueue *queue, ConfigSnapshot *snapshot, QObject *parent = nullptr);
+
+  /**
+   * @brief Starts accepting clients. A gateway already listening is closed first.
+   * @param port The TCP port.
+   * @param address The address to listen on, only the local host by default.
+   * @return false if the port cannot be opened, see errorString().
+   */
+  bool listen(quint16 port, const QHostAddress &address = QHostAddress::LocalHost);
+
+  /**
+   * @brief Disconnects all clients and stops listening.
+   */
+  void close();
+
+  bool isListening() const;
+  quint16 port() const;
+  QString errorString() const;
+  int clientCount() const;
+
+  /**
+   * @brief Sets the device that unit identifiers 0 and 255 address.
+   * @param serverAddress The Modbus slave address on the serial line.
+   */
+  void setDefaultServer(int serverAddress);
+  int defaultServer() const;
+
+  /**
+   * @brief Sets the age up to which cached registers answer a read.
+   * @param maxAge The age in milliseconds, 0 to send every read to the bus.
+   */
+  void setMaxAge(int maxAge);
+  int maxAge() const;
+
+  quint64 cacheHits() const;
+  quint64 forwarded() const;
+
+signals:
+  /**
+   * @brief Emitted when a write of a client has been accepted by the controller.
+   * @param serverAddress The address of the device.
+   * @param start The first register address written.
+   * @param values The register values written.
+   */
+  void written(int serverAddress, quint16 start, const QVector<quint16> &values);
+
+  /**
+   * @brief Emitted when a client connects or disconnects.
+   * @param clients The number of connected clients.
+   */
+  void clientCountChanged(int clients);
+
+private:
+  ModbusQueue *queue_{nullptr}; /**< Queue of the serial bus */
+  ConfigSnapshot *snapshot_{nullptr}; /**< Register cache filled by the status poll */
+  QTcpServer *server_{nullptr}; /**< Listening socket */
+  QHash<QTcpSocket*, QByteArray> buffers_; /**< Bytes received but not yet framed, per client */
+  mutable QMutex mutex_; /**< Mutex guarding the settings and counters read from other threads */
+  int defaultServer_{1}; /**< Device addressed by unit identifiers 0 and 255 */
+  int maxAge_{maxAgeDefault}; /**< Age in ms up to which cached registers answer a read */
+  quint64 cacheHits_{0}; /**< Reads answered from the cache */
+  quint64 forwarded_{0}; /**< Requests sent to the bus */
+
+  /**
+   * @brief Accepts the pending connections.
+   */
+  void acceptClients();
+
+  /**
+   * @brief Splits the received bytes of a client into frames and handles them.
+   */
+  void readClient(QTcpSocket *socket);
+
+  /**
+   * @brief Answers one request, from the cache or through the bus.
+   */
+  void handle(QTcpSocket *socket, quint16 transaction, quint8 unit, const QModbusRequest &request);
+
+  /**
+   * @brief Reads a register range from the cache.
+   * @return false if a register is missing or older than maxAge().
+   */
+  bool readCache(int serverAddress, quint16 start, int count, QVector<quint16> &values) const;
+
+  /**
+   * @brief Returns the big-endian register values of request data.
+   * @return An empty vector if the data is too short.
+   */
+  static QVector<quint16> words(const QByteArray &data, int offset, int count);
+
+  /**
+   * @brief Sends a response with the MBAP header of its request.
+   */
+  static void reply(QTcpSocket *socket, quint16 transaction, quint8 unit, const QModbusPdu &pdu);
+};
+
+#endif // MODBUSGATEWAY_H
@@ -0,0 +1,256 @@
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTimer>
+#include "modbusqueue.h"
+#include "framecapture.h"
+#include "modbusstats.h"
+
+namespace {
+quint16 word(const QByteArray &data, int offset){
+  return static_cast<quint16>((static_cast<quint8>(data.at(offset)) << 8) | static_cast<quint8>(data.at(offset + 1)));
+}
+}
+
+quint16 ModbusResult::startAddress() const {
+  const QByteArray data = request.data();
+  if (data.size() < 2) return 0;
+  return word(data, 0);
+}
+
+/**
+ * @details Read responses start with a byte count followed by the register values in big endian order.
+ */
+QVector<quint16> ModbusResult::values() const {
+  QVector<quint16> values;
+  switch (response.functionCode()) {
+    case QModbusPdu::ReadHoldingRegisters:
+    case QModbusPdu::ReadInputRegisters:
+    case QModbusPdu::ReadWriteMultipleRegisters: {
+      const QByteArray data = response.data();
+      if (data.isEmpty()) break;
+      const int byteCount = qMin(static_cast<int>(static_cast<quint8>(data.at(0))), data.size() - 1);
+      values.reserve(byteCount / 2);
+      for (int i = 1; i + 1 <= byteCount; i += 2) values.append(word(data, i));
+      break;
+    }
+    default:
+      break;
+  }
+  return values;
+}
+
+ModbusQueue::ModbusQueue(QObject *parent)
+  : QObject(parent)
+{
+}
+
+void ModbusQueue::setStats(ModbusStats *stats){stats_ = stats;}
+void ModbusQueue::setCapture(FrameCapture *capture){capture_ = capture;}
+
+void ModbusQueue::setTransport(ModbusTransport *transport){
+  disconnect(transportConnected_);
+  transport_ = transport;
+  if (transport_) transportConnected_ = connect(transport_, &ModbusTransport::connected, this, &ModbusQueue::dispatch);
+}
+
+/**
+ * @details A rejected request completes at once with QModbusDevice::ReplyAbortedError, so a
+ * caller counting outstanding replies never waits for one that cannot come.
+ */
+bool ModbusQueue::enqueue(const QModbusRequest &request, int serverAddress, Handler handler, Lane lane){
+  QQueue<Transaction> &queue = (lane == Lane::Low) ? pendingLow_ : pending_;
+  Transaction transaction;
+  transaction.request = request;
+  transaction.serverAddress = serverAddress;
+  transaction.handler = std::move(handler);
+  transaction.lane = lane;
+  if (queue.size() >= maxPending_) {
+    emit rejected(serverAddress);
+    ModbusResult result;
+    result.error = QModbusDevice::ReplyAbortedError;
+    result.errorString = tr("Request queue is full");
+    complete(transaction, result);
+    return false;
+  }
+  queue.enqueue(transaction);
+  dispatch();
+  return true;
+}
+
+void ModbusQueue::clear(){
+  const QList<Transaction> dropped = pending_ + pendingLow_;
+  pending_.clear();
+  pendingLow_.clear();
+  for (const Transaction &transaction : dropped) {
+    ModbusResult result;
+    result.error = QModbusDevice::ReplyAbortedError;
+    result.errorString = tr("Request dropped from the queue");
+    complete(transaction, result);
+  }
+}
+
+/**
+ * @details The high lane is served first. The low lane may only use the slots the high lane
+ * leaves free, minus one that is kept for the next high request when more than one request may
+ * be outstanding. After lowShare() high requests in a row a waiting low request is taken anyway.
+ */
+bool ModbusQueue::takeNext(Transaction &transaction){
+  const bool lowAllowed = !pendingLow_.isEmpty() && lowInFlight_ < qMax(1, maxInFlight_ - 1);
+  const bool lowTurn = lowAllowed && (pending_.isEmpty() || highInARow_ >= lowShare_);
+  if (lowTurn) {
+    transaction = pendingLow_.dequeue();
+    highInARow_ = 0;
+    return true;
+  }
+  if (pending_.isEmpty()) return false;
+  transaction = pending_.dequeue();
+  highInARow_ = pendingLow_.isEmpty() ? 0 : highInARow_ + 1;
+  return true;
+}
+
+/**
+ * @details Requests of a lane are sent in order. While the transport is connecting they stay in
+ * the queue. When the transport is missing or not connected the handler is called at once with
+ * QModbusDevice::ConnectionError, so callers never wait for a reply that cannot come.
+ */
+void ModbusQueue::dispatch(){
+  if (dispatching_) return;
+  dispatching_ = true;
+  Transaction transaction;
+  while (inFlight_ < maxInFlight_) {
+    if (transport_ && transport_->state() == QModbusDevice::ConnectingState) break;
+    if (!takeNext(transaction)) break;
+    if (!transport_ || !transport_->isConnected()) {
+      ModbusResult result;
+      result.error = QModbusDevice::ConnectionError;
+      result.errorString = tr("Device is not connected");
+      if (stats_) stats_->recordUnsent(result);
+      complete(transaction, result);
+      continue;
+    }
+    const int timeout = adaptiveTimeout_ ? rtt_.timeout(transaction.serverAddress, wireTime(transaction.request)) : 0;
+    QModbusReply *reply = transport_->sendRawRequest(transaction.request, transaction.serverAddress, timeout);
+    if (!reply) {
+      ModbusResult result;
+      result.error = transport_->error();
+      result.errorString = transport_->errorString();
+      if (stats_) stats_->recordUnsent(result);
+      complete(transaction, result);
+      continue;
+    }
+    if (reply->isFinished()) {
+      // broadcast replies return immediately
+      const ModbusResult result = toResult(transaction, reply);
+      if (capture_) capture_->record(result, static_cast<int>(transaction.lane), transaction.attempt, 0);
+      complete(transaction, result);
+      reply->deleteLater();
+      continue;
+    }
+    inFlight_++;
+    if (transaction.lane == Lane::Low) lowInFlight_++;
+    QElapsedTimer sent;
+    sent.start();
+    connect(reply, &QModbusReply::finished, this, [this, transaction, reply, sent]() {
+      inFlight_--;
+      if (transaction.lane == Lane::Low) lowInFlight_--;
+      const ModbusResult result = toResult(transaction, reply);
+      if (stats_) stats_->record(result, sent.elapsed());
+      if (capture_) capture_->record(result, static_cast<int>(transaction.lane), transaction.attempt, sent.nsecsElapsed());
+      if (!retry(transaction, result, sent.elapsed())) complete(transaction, result);
+      reply->deleteLater();
+      dispatch();
+    });
+  }
+  dispatching_ = false;
+  if (isIdle()) emit idle();
+}
+
+/**
+ * @details Only the round trips of first attempts are recorded (Karn's algorithm), since the
+ * reply of a retried request may belong to any of its attempts. A retry goes back to the head of
+ * its lane after a random delay of up to retryJitter milliseconds.
+ */
+bool ModbusQueue::retry(const Transaction &transaction, const ModbusResult &result, qint64 elapsed){
+  if (result.error == QModbusDevice::TimeoutError) {
+    rtt_.backoff(transaction.serverAddress);
+  } else if (transaction.attempt == 0 && result.error != QModbusDevice::ConnectionError
+             && result.error != QModbusDevice::ReplyAbortedError) {
+    rtt_.record(transaction.serverAddress, elapsed - wireTime(transaction.request));
+  }
+  if (result.error != QModbusDevice::TimeoutError || transaction.attempt >= maxRetries_) return false;
+  if (!transport_ || !transport_->isConnected()) return false;
+  Transaction again = transaction;
+  again.attempt++;
+  retrying_++;
+  QTimer::singleShot(QRandomGenerator::global()->bounded(retryJitter + 1), this, [this, again]() {
+    retrying_--;
+    QQueue<Transaction> &queue = (again.lane == Lane::Low) ? pendingLow_ : pending_;
+    queue.prepend(again);
+    dispatch();
+  });
+  return true;
+}
+
+/**
+ * @details An RTU character carries a start bit, the data bits, the parity bit and the stop bits.
+ * The response length is taken from the register count of a read, any other reply is assumed to
+ * be eight bytes long like a write echo. Each frame is followed by a silence of 3.5 characters.
+ */
+int ModbusQueue::wireTime(const QModbusRequest &request) const {
+  if (!transport_) return 0;
+  const ModbusTransport::Settings settings = transport_->settings();
+  if (settings.type != ModbusTransport::Type::Rtu || settings.baudRate <= 0) return 0;
+  const QByteArray data = request.data();
+  int responseBytes = 8;
+  switch (request.functionCode()) {
+    case QModbusPdu::ReadHoldingRegisters:
+    case QModbusPdu::ReadInputRegisters:
+    case QModbusPdu::ReadWriteMultipleRegisters:
+      if (data.size() >= 4) responseBytes = 5 + 2 * word(data, 2);
+      break;
+    default:
+      break;
+  }
+  const int requestBytes = request.size() + 3;
+  double stopBits = 1.0;
+  switch (settings.stopBits) {
+    case QSerialPort::OneAndHalfStop: stopBits = 1.5; break;
+    case QSerialPort::TwoStop: stopBits = 2.0; break;
+    default: break;
+  }
+  const double bitsPerChar = 1 + settings.dataBits + (settings.parity != QSerialPort::NoParity ? 1 : 0) + stopBits;
+  const double chars = requestBytes + responseBytes + 7.0;
+  return static_cast<int>(chars * bitsPerChar * 1000.0 / settings.baudRate + 0.5);
+}
+
+void ModbusQueue::complete(const Transaction &transaction, ModbusResult result){
+  result.request = transaction.request;
+  result.serverAddress = transaction.serverAddress;
+  if (transaction.handler) transaction.handler(result);
+}
+
+ModbusResult ModbusQueue::toResult(const Transaction &transaction, const QModbusReply *reply){
+  ModbusResult result;
+  result.request = transaction.request;
+  result.serverAddress = transaction.serverAddress;
+  result.response = reply->rawResult();
+  result.error = reply->error();
+  result.errorString = reply->errorString();
+  return result;
+}
+
+void ModbusQueue::setMaxInFlight(int count){maxInFlight_ = qMax(1, count); dispatch();}
+void ModbusQueue::setMaxPending(int count){maxPending_ = qMax(1, count);}
+void ModbusQueue::setLowShare(int count){lowShare_ = qMax(1, count);}
+void ModbusQueue::setAdaptiveTimeout(bool enable){adaptiveTimeout_ = enable;}
+void ModbusQueue::setMaxRetries(int retries){maxRetries_ = qMax(0, retries);}
+RttEstimator* ModbusQueue::rttEstimator(){return &rtt_;}
+bool ModbusQueue::isAdaptiveTimeout() const {return adaptiveTimeout_;}
+int ModbusQueue::maxRetries() const {return maxRetries_;}
+int ModbusQueue::maxInFlight() const {return maxInFlight_;}
+int ModbusQueue::maxPending() const {return maxPending_;}
+int ModbusQueue::lowShare() const {return lowShare_;}
+int ModbusQueue::pendingCount() const {return pending_.size() + pendingLow_.size();}
+int ModbusQueue::pendingCount(Lane lane) const {return (lane == Lane::Low) ? pendingLow_.size() : pending_.size();}
+int ModbusQueue::inFlightCount() const {return inFlight_;}
+bool ModbusQueue::isIdle() const {return inFlight_ == 0 && retrying_ == 0 && pending_.isEmpty() && pendingLow_.isEmpty();}
@@ -0,0 +1,271 @@
+/**
+ * @file modbusqueue.h
+ * @brief Declaration of the ModbusQueue class, the request pipeline used by Communication.
+ */
+
+#ifndef MODBUSQUEUE_H
+#define MODBUSQUEUE_H
+
+#include <QObject>
+#include <QQueue>
+#include <QVector>
+#include <QModbusClient>
+#include <QModbusReply>
+#include <functional>
+#include "modbustransport.h"
+#include "rttestimator.h"
+
+class FrameCapture;
+class ModbusStats;
+
+/**
+ * @brief The ModbusResult struct carries the outcome of one Modbus transaction.
+ *
+ * The request is kept next to the response, so a handler always knows which registers
+ * the reply belongs to, no matter when the reply arrives.
+ */
+struct ModbusResult
+{
+  QModbusRequest request; /**< The request that was sent */
+  QModbusResponse response; /**< The raw response of the device */
+  QModbusDevice::Error error{QModbusDevice::NoError}; /**< Error of the transaction */
+  QString errorString; /**< Human readable error description */
+  int serverAddress{}; /**< Address of the device the request was sent to */
+
+  /**
+   * @brief Checks whether the transaction finished without error.
+   * @return true if no error occurred.
+   */
+  bool isValid() const {return error == QModbusDevice::NoError;}
+
+  /**
+   * @brief Returns the first register address addressed by the request.
+   * @return The start address, or 0 if the function code carries no address.
+   */
+  quint16 startAddress() const;
+
+  /**
+   * @brief Returns the register values of a read response.
+   * @return The values of the registers, or an empty vector if the response carries none.
+   */
+  QVector<quint16> values() const;
+};
+
+/**
+ * @brief The ModbusQueue class serializes Modbus transactions onto a ModbusTransport.
+ *
+ * Each request is queued together with its own completion handler. The handler is called
+ * with the reply of exactly that request, so replies can never be decoded as another
+ * register. At most maxInFlight() requests are outstanding on the bus, and the queue
+ * refuses new requests once maxPending() requests are waiting in a lane. The next request
+ * is sent as soon as a reply arrives, without any fixed sleep in between.
+ *
+ * Requests wait in one of two lanes. The high lane carries the status polls and the writes
+ * the safety of the process depends on, the low lane configuration reads and diagnostics.
+ * A waiting high request is always sent before a low one, so browsing registers delays a
+ * status poll by one transaction at most. One slot of a pipelined transport is kept free
+ * for the high lane, and a low request is let through after lowShare() high requests in a
+ * row, so a saturated line cannot starve the low lane either.
+ *
+ * With the adaptive timeout the response timeout of every request comes from the RttEstimator
+ * of its device, so a lost frame costs a few round trips instead of a fixed timeout. A request
+ * that timed out is sent again up to maxRetries() times, each after a random delay, so several
+ * devices that lost frames together do not collide again.
+ */
+class ModbusQueue : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * @brief Completion handler called once for every queued request.
+   */
+  using Handler = std::function<void(const ModbusResult &result)>;
+
+  /**
+   * @brief The Lane enum class defines the priority of a request.
+   */
+  enum class Lane {
+    High, /**< Status polls, operation commands and safety writes */
+    Low /**< Configuration reads, autotuning commands and diagnostics */
+  };
+
+  /**
+   * @brief The limits enumeration defines the default fairness of the lanes.
+   */
+  enum limits {
+    lowShareDefault = 8, /**< High requests sent in a row before a waiting low request gets its turn */
+    maxRetriesDefault = 2, /**< Retries of a request that timed out */
+    retryJitter = 20 /**< Largest random delay in milliseconds before a retry */
+  };
+
+  /**
+   * @brief Constructs an empty queue.
+   * @param parent The parent object.
+   */
+  explicit ModbusQueue(QObject *parent = nullptr);
+
+  /**
+   * @brief Sets the transport the requests are sent with.
+   * @param transport The transport. The queue does not take ownership.
+   * @details Requests queued while the transport is still connecting wait for the connection.
+   */
+  void setTransport(ModbusTransport *transport);
+
+  /**
+   * @brief Sets the statistics every transaction is recorded in.
+   * @param stats The statistics, or nullptr to record nothing. The queue does not take ownership.
+   */
+  void setStats(ModbusStats *stats);
+
+  /**
+   * @brief Sets the capture every completed transaction is written to.
+   * @param capture The capture, or nullptr to write nothing. The queue does not take ownership.
+   */
+  void setCapture(FrameCapture *capture);
+
+  /**
+   * @brief Queues a request.
+   * @param request The request PDU.
+   * @param serverAddress The address of the device.
+   * @param handler The handler called with the result of the request, also for a rejected request.
+   * @param lane The lane the request waits in.
+   * @return false if the lane is full and the request was rejected with QModbusDevice::ReplyAbortedError.
+   */
+  bool enqueue(const QModbusRequest &request, int serverAddress, Handler handler = Handler(), Lane lane = Lane::High);
+
+  /**
+   * @brief Drops all requests that have not been sent yet.
+   *
+   * The handlers of the dropped requests are called with QModbusDevice::ReplyAbortedError.
+   */
+  void clear();
+
+  /**
+   * @brief Sets the number of requests that may be outstanding at the same time.
+   * @param count The number of requests. Serial lines only allow one, see ModbusTransport::maxInFlight().
+   */
+  void setMaxInFlight(int count);
+
+  /**
+   * @brief Sets the number of requests that may wait in the queue.
+   * @param count The number of requests.
+   */
+  void setMaxPending(int count);
+
+  /**
+   * @brief Sets how many high requests are sent in a row while a low request is waiting.
+   * @param count The number of high requests, at least 1.
+   */
+  void setLowShare(int count);
+
+  /**
+   * @brief Enables or disables the response timeout derived from the measured round trips.
+   * @param enable false to use the fixed timeout of the transport settings.
+   */
+  void setAdaptiveTimeout(bool enable);
+
+  /**
+   * @brief Sets how often a request that timed out is sent again.
+   * @param retries The number of retries, 0 for none.
+   */
+  void setMaxRetries(int retries);
+
+  /**
+   * @brief Returns the round trip estimator, e.g. to set its bounds.
+   * @return The estimator owned by the queue.
+   */
+  RttEstimator* rttEstimator();
+
+  bool isAdaptiveTimeout() const;
+  int maxRetries() const;
+  int maxInFlight() const;
+  int maxPending() const;
+  int lowShare() const;
+  int pendingCount() const;
+  int pendingCount(Lane lane) const;
+  int inFlightCount() const;
+
+  /**
+   * @brief Checks whether no request is waiting or outstanding.
+   * @return true if the queue is idle.
+   */
+  bool isIdle() const;
+
+signals:
+  /**
+   * @brief Emitted when the last outstanding request has completed.
+   */
+  void idle();
+
+  /**
+   * @brief Emitted when a request is refused because the queue is full.
+   * @param serverAddress The address of the device the request was meant for.
+   */
+  void rejected(int serverAddress);
+
+private:
+  /**
+   * @brief The Transaction struct holds a queued request and its handler.
+   */
+  struct Transaction {
+    QModbusRequest request; /**< The request PDU */
+    int serverAddress{}; /**< Address of the device */
+    Handler handler; /**< Completion handler */
+    Lane lane{Lane::High}; /**< Lane the request waited in */
+    int attempt{0}; /**< Number of times the request has been sent before */
+  };
+
+  ModbusTransport *transport_{nullptr}; /**< The transport the requests are sent with */
+  ModbusStats *stats_{nullptr}; /**< Latency and error statistics of the transactions */
+  FrameCapture *capture_{nullptr}; /**< Capture file of the transactions */
+  QMetaObject::Connection transportConnected_; /**< Connection that resumes dispatching once the transport is up */
+  QQueue<Transaction> pending_; /**< Requests waiting in the high lane */
+  QQueue<Transaction> pendingLow_; /**< Requests waiting in the low lane */
+  int inFlight_{0}; /**< Number of outstanding requests */
+  int lowInFlight_{0}; /**< Number of outstanding requests of the low lane */
+  int highInARow_{0}; /**< High requests sent while a low request was waiting */
+  int lowShare_{lowShareDefault}; /**< High requests in a row before a low request gets its turn */
+  RttEstimator rtt_; /**< Round trip estimates per device */
+  bool adaptiveTimeout_{true}; /**< Flag indicating if the timeout follows the round trips */
+  int maxRetries_{maxRetriesDefault}; /**< Retries of a request that timed out */
+  int retrying_{0}; /**< Requests waiting for the delay before their retry */
+  int maxInFlight_{1}; /**< Maximum number of outstanding requests */
+  int maxPending_{64}; /**< Maximum number of waiting requests */
+  bool dispatching_{false}; /**< Guard against re-entrant dispatching from handlers */
+
+  /**
+   * @brief Sends waiting requests while the in-flight limit allows it.
+   */
+  void dispatch();
+
+  /**
+   * @brief Takes the next request to send from the lanes.
+   * @param transaction Receives the request.
+   * @return false if no lane may send now.
+   */
+  bool takeNext(Transaction &transaction);
+
+  /**
+   * @brief Handles the reply of a sent transaction: updates the estimate and retries a timeout.
+   * @return true if the transaction will be sent again, false if it is complete.
+   */
+  bool retry(const Transaction &transaction, const ModbusResult &result, qint64 elapsed);
+
+  /**
+   * @brief Calls the handler of a transaction with the given result.
+   */
+  void complete(const Transaction &transaction, ModbusResult result);
+
+  /**
+   * @brief Returns the time a request and its response spend on a serial line.
+   * @return The transmission time in milliseconds, 0 for a transport that is not RTU.
+   */
+  int wireTime(const QModbusRequest &request) const;
+
+  /**
+   * @brief Converts a finished reply into a ModbusResult.
+   */
+  static ModbusResult toResult(const Transaction &transaction, const QModbusReply *reply);
+};
+
+#endif // MODBUSQUEUE_H
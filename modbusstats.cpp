@@ -0,0 +1,108 @@
+#include "modbusstats.h"
+
+const QVector<int>& ModbusStats::bucketBounds(){
+  static const QVector<int> bounds{5, 10, 20, 30, 50, 75, 100, 150, 200, 300, 500, 700, 1000, 2000, 5000};
+  return bounds;
+}
+
+/**
+ * @details The percentile is located in the bucket where the cumulative count reaches the
+ * fraction and interpolated linearly between the bounds of that bucket. Values in the overflow
+ * bucket are reported as the longest latency seen.
+ */
+double ModbusStats::Entry::percentile(double fraction) const {
+  if (count == 0 || histogram.isEmpty()) return 0.0;
+  const QVector<int> &bounds = bucketBounds();
+  const double target = qBound(0.0, fraction, 1.0) * count;
+  quint64 cumulative = 0;
+  for (int i = 0; i < histogram.size(); i++) {
+    const quint64 inBucket = histogram.at(i);
+    if (inBucket == 0 || cumulative + inBucket < target) {
+      cumulative += inBucket;
+      continue;
+    }
+    if (i >= bounds.size()) return static_cast<double>(maxLatency);
+    const double lower = (i == 0) ? 0.0 : bounds.at(i - 1);
+    const double upper = qMin(static_cast<double>(bounds.at(i)), static_cast<double>(maxLatency));
+    const double position = (target - cumulative) / inBucket;
+    return lower + qMax(0.0, upper - lower) * position;
+  }
+  return static_cast<double>(maxLatency);
+}
+
+double ModbusStats::Entry::mean() const {return count == 0 ? 0.0 : static_cast<double>(sumLatency) / count;}
+
+void ModbusStats::Entry::merge(const Entry &other){
+  count += other.count;
+  timeouts += other.timeouts;
+  exceptions += other.exceptions;
+  errors += other.errors;
+  for (auto it = other.exceptionCodes.cbegin(); it != other.exceptionCodes.cend(); ++it) exceptionCodes[it.key()] += it.value();
+  if (histogram.size() < other.histogram.size()) histogram.resize(other.histogram.size());
+  for (int i = 0; i < other.histogram.size(); i++) histogram[i] += other.histogram.at(i);
+  maxLatency = qMax(maxLatency, other.maxLatency);
+  sumLatency += other.sumLatency;
+}
+
+void ModbusStats::record(const ModbusResult &result, qint64 latency){
+  const int functionCode = result.request.functionCode();
+  const quint16 address = result.startAddress();
+  QMutexLocker locker(&mutex_);
+  Entry &entry = entries_[(static_cast<quint32>(functionCode) << 16) | address];
+  if (entry.histogram.isEmpty()) {
+    entry.functionCode = functionCode;
+    entry.address = address;
+    entry.histogram.resize(bucketBounds().size() + 1);
+  }
+  const QVector<int> &bounds = bucketBounds();
+  int bucket = 0;
+  while (bucket < bounds.size() && latency > bounds.at(bucket)) bucket++;
+  entry.histogram[bucket]++;
+  entry.count++;
+  entry.maxLatency = qMax(entry.maxLatency, latency);
+  entry.sumLatency += latency;
+  switch (result.error) {
+    case QModbusDevice::NoError:
+      break;
+    case QModbusDevice::TimeoutError:
+      entry.timeouts++;
+      break;
+    case QModbusDevice::ProtocolError:
+      if (result.response.isException()) {
+        entry.exceptions++;
+        entry.exceptionCodes[result.response.exceptionCode()]++;
+      } else {
+        entry.errors++;
+      }
+      break;
+    default:
+      entry.errors++;
+      break;
+  }
+}
+
+void ModbusStats::recordUnsent(const ModbusResult &result){
+  Q_UNUSED(result)
+  QMutexLocker locker(&mutex_);
+  unsent_++;
+}
+
+QVector<ModbusStats::Entry> ModbusStats::entries() const {
+  QMutexLocker locker(&mutex_);
+  return entries_.values().toVector();
+}
+
+ModbusStats::Entry ModbusStats::total() const {
+  QMutexLocker locker(&mutex_);
+  Entry sum;
+  for (const Entry &entry : entries_) sum.merge(entry);
+  return sum;
+}
+
+quint64 ModbusStats::unsent() const {QMutexLocker locker(&mutex_); return unsent_;}
+
+void ModbusStats::reset(){
+  QMutexLocker locker(&mutex_);
+  entries_.clear();
+  unsent_ = 0;
+}
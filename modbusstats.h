@@ -0,0 +1,110 @@
+/**
+ * @file modbusstats.h
+ * @brief Declaration of the ModbusStats class, which collects latency and error statistics of the Modbus transactions.
+ */
+
+#ifndef MODBUSSTATS_H
+#define MODBUSSTATS_H
+
+#include <QMap>
+#include <QMutex>
+#include <QVector>
+#include "modbusqueue.h"
+
+/**
+ * @brief The ModbusStats class records the round-trip time and outcome of every transaction.
+ *
+ * Transactions are grouped by function code and start register. For each group the class keeps
+ * a latency histogram with fixed bucket bounds, from which the percentiles are estimated, and
+ * counters of timeouts, Modbus exception codes and other errors. Frames discarded by the RTU
+ * master for a wrong CRC show up as timeouts, since the device never gets a valid reply through.
+ * Recording and reading are guarded by a mutex, so the statistics can be read from the GUI thread
+ * while the bus thread records.
+ */
+class ModbusStats
+{
+public:
+  /**
+   * @brief The Entry struct holds the statistics of one function code and start register.
+   */
+  struct Entry {
+    int functionCode{}; /**< Modbus function code */
+    quint16 address{}; /**< Start register of the requests */
+    quint64 count{0}; /**< Number of transactions that were sent */
+    quint64 timeouts{0}; /**< Number of transactions without reply */
+    quint64 exceptions{0}; /**< Number of exception responses */
+    quint64 errors{0}; /**< Number of other failed transactions */
+    QMap<int, quint64> exceptionCodes; /**< Number of exception responses per exception code */
+    QVector<quint64> histogram; /**< Number of transactions per latency bucket */
+    qint64 maxLatency{0}; /**< Longest round-trip time in milliseconds */
+    qint64 sumLatency{0}; /**< Sum of the round-trip times in milliseconds */
+
+    /**
+     * @brief Estimates a latency percentile from the histogram.
+     * @param fraction The percentile as a fraction, e.g. 0.95.
+     * @return The latency in milliseconds, interpolated within the bucket.
+     */
+    double percentile(double fraction) const;
+
+    /**
+     * @brief Returns the mean round-trip time.
+     * @return The latency in milliseconds.
+     */
+    double mean() const;
+
+    /**
+     * @brief Adds the statistics of another entry.
+     * @param other The entry to add.
+     */
+    void merge(const Entry &other);
+  };
+
+  /**
+   * @brief Returns the upper bounds of the latency buckets in milliseconds.
+   * @return The bounds. The last bucket collects everything above the last bound.
+   */
+  static const QVector<int>& bucketBounds();
+
+  /**
+   * @brief Records a completed transaction.
+   * @param result The result of the transaction.
+   * @param latency The round-trip time in milliseconds.
+   */
+  void record(const ModbusResult &result, qint64 latency);
+
+  /**
+   * @brief Records a transaction that could not be sent.
+   * @param result The result of the transaction.
+   */
+  void recordUnsent(const ModbusResult &result);
+
+  /**
+   * @brief Returns the statistics of all groups.
+   * @return The entries sorted by function code and start register.
+   */
+  QVector<Entry> entries() const;
+
+  /**
+   * @brief Returns the statistics of all transactions together.
+   * @return The sum of all entries.
+   */
+  Entry total() const;
+
+  /**
+   * @brief Returns the number of transactions that could not be sent, e.g. while disconnected.
+   * @return The number of transactions.
+   */
+  quint64 unsent() const;
+
+  /**
+   * @brief Clears all statistics.
+   */
+  void reset();
+
+private:
+  mutable QMutex mutex_; /**< Mutex guarding the statistics */
+  QMap<quint32, Entry> entries_; /**< Statistics keyed by function code and start register */
+  quint64 unsent_{0}; /**< Number of transactions that could not be sent */
+};
+
+#endif // MODBUSSTATS_H
@@ -0,0 +1,214 @@
+#include <QModbusRtuSerialMaster>
+#include <QModbusTcpClient>
+#include <QUrl>
+#include <QUrlQuery>
+#include "modbustransport.h"
+
+ModbusTransport::Settings ModbusTransport::parse(const QString &endpoint){
+  Settings settings;
+  const QUrl url(endpoint);
+  if (url.scheme() == QLatin1String("tcp") && !url.host().isEmpty()) {
+    settings.type = Type::Tcp;
+    settings.host = url.host();
+    settings.port = url.port(settings.port);
+  } else if (url.scheme() == QLatin1String("replay") && !url.path().isEmpty()) {
+    settings.type = Type::Replay;
+    settings.captureFile = url.path();
+    settings.realTime = !QUrlQuery(url).hasQueryItem(QStringLiteral("fast"));
+  } else {
+    settings.portName = endpoint;
+  }
+  return settings;
+}
+
+ModbusTransport::ModbusTransport(QObject *parent)
+  : QObject(parent)
+{
+  reconnectTimer_ = new QTimer(this);
+  reconnectTimer_->setSingleShot(true);
+  connect(reconnectTimer_, &QTimer::timeout, this, &ModbusTransport::reconnect);
+}
+
+ModbusTransport::~ModbusTransport(){
+  wanted_ = false;
+  if (client_) client_->disconnectDevice();
+}
+
+void ModbusTransport::setSettings(const Settings &settings){
+  const bool reopen = wanted_;
+  replayOpen_ = false;
+  if (client_) {
+    wanted_ = false;
+    client_->disconnectDevice();
+    client_->deleteLater();
+    client_ = nullptr;
+  }
+  settings_ = settings;
+  createClient();
+  if (reopen) connectDevice();
+}
+
+void ModbusTransport::createClient(){
+  if (settings_.type == Type::Replay) return;
+  if (settings_.type == Type::Tcp) {
+    client_ = new QModbusTcpClient(this);
+    client_->setConnectionParameter(QModbusDevice::NetworkAddressParameter, settings_.host);
+    client_->setConnectionParameter(QModbusDevice::NetworkPortParameter, settings_.port);
+  } else {
+    client_ = new QModbusRtuSerialMaster(this);
+    client_->setConnectionParameter(QModbusDevice::SerialPortNameParameter, settings_.portName);
+    client_->setConnectionParameter(QModbusDevice::SerialBaudRateParameter, settings_.baudRate);
+    client_->setConnectionParameter(QModbusDevice::SerialDataBitsParameter, settings_.dataBits);
+    client_->setConnectionParameter(QModbusDevice::SerialParityParameter, settings_.parity);
+    client_->setConnectionParameter(QModbusDevice::SerialStopBitsParameter, settings_.stopBits);
+  }
+  client_->setTimeout(settings_.timeout);
+  client_->setNumberOfRetries(settings_.numberOfRetries);
+  connect(client_, &QModbusDevice::stateChanged, this, &ModbusTransport::onStateChanged);
+  connect(client_, &QModbusDevice::errorOccurred, this, [this](QModbusDevice::Error error) {
+    if (client_) emit errorOccurred(error, client_->errorString());
+  });
+}
+
+bool ModbusTransport::connectDevice(){
+  if (settings_.type == Type::Replay) return openReplay();
+  if (!client_) createClient();
+  wanted_ = true;
+  attempts_ = 0;
+  reconnectTimer_->stop();
+  if (client_->state() != QModbusDevice::UnconnectedState) return true;
+  if (client_->connectDevice()) return true;
+  scheduleReconnect();
+  return false;
+}
+
+void ModbusTransport::disconnectDevice(){
+  wanted_ = false;
+  reconnectTimer_->stop();
+  if (client_) client_->disconnectDevice();
+  if (replayOpen_) {
+    replayOpen_ = false;
+    emit disconnected();
+  }
+}
+
+bool ModbusTransport::openReplay(){
+  wanted_ = true;
+  replayNext_ = 0;
+  replayError_.clear();
+  if (!FrameCapture::load(settings_.captureFile, replay_, &replayError_)) {
+    wanted_ = false;
+    emit errorOccurred(QModbusDevice::ConnectionError, errorString());
+    return false;
+  }
+  replayOpen_ = true;
+  emit connected();
+  return true;
+}
+
+/**
+ * @details The reply is the next record of the same request to the same device, searched from
+ * the record after the last match and wrapping around, so the polls pick up the capture in order
+ * and a short capture plays in a loop. A request that was never recorded times out.
+ */
+QModbusReply* ModbusTransport::replayRequest(const QModbusRequest &request, int serverAddress, int timeout){
+  if (!replayOpen_) return nullptr;
+  QModbusReply *reply = new QModbusReply(serverAddress == 0 ? QModbusReply::Broadcast : QModbusReply::Raw, serverAddress, this);
+  if (serverAddress == 0) {
+    reply->setFinished(true);
+    return reply;
+  }
+  int found = -1;
+  for (int i = 0; i < replay_.size() && found < 0; i++) {
+    const int index = (replayNext_ + i) % replay_.size();
+    const FrameCapture::Record &record = replay_.at(index);
+    if (record.serverAddress == serverAddress && record.request.functionCode() == request.functionCode()
+        && record.request.data() == request.data()) found = index;
+  }
+  if (found < 0) {
+    QTimer::singleShot(settings_.realTime ? (timeout > 0 ? timeout : settings_.timeout) : 0, reply, [reply]() {
+      reply->setError(QModbusDevice::TimeoutError, tr("Request not found in the capture"));
+    });
+    return reply;
+  }
+  replayNext_ = found + 1;
+  const FrameCapture::Record record = replay_.at(found);
+  const int delay = settings_.realTime ? static_cast<int>(record.roundTrip / 1000) : 0;
+  QTimer::singleShot(delay, reply, [reply, record]() {
+    reply->setRawResult(record.response);
+    if (record.error == QModbusDevice::NoError) reply->setFinished(true);
+    else reply->setError(record.error, tr("Recorded error"));
+  });
+  return reply;
+}
+
+/**
+ * @details A connection that drops while it is wanted is reopened by the reconnect timer, so
+ * a gateway reboot or a short cable glitch does not need a click on the Connect button.
+ */
+void ModbusTransport::onStateChanged(QModbusDevice::State state){
+  if (state == QModbusDevice::ConnectedState) {
+    attempts_ = 0;
+    reconnectTimer_->stop();
+    emit connected();
+  } else if (state == QModbusDevice::UnconnectedState) {
+    emit disconnected();
+    if (wanted_ && !reconnectTimer_->isActive()) scheduleReconnect();
+  }
+}
+
+void ModbusTransport::reconnect(){
+  if (!wanted_ || !client_ || client_->state() != QModbusDevice::UnconnectedState) return;
+  emit reconnecting(++attempts_);
+  if (!client_->connectDevice()) scheduleReconnect();
+}
+
+/**
+ * @details The time doubles with every failed attempt, so an adapter that is gone for hours
+ * does not flood the log, while a short glitch is bridged within a few seconds.
+ */
+void ModbusTransport::scheduleReconnect(){
+  const qint64 interval = static_cast<qint64>(reconnectInterval_) << qMin(attempts_, 16);
+  reconnectTimer_->start(static_cast<int>(qMin<qint64>(interval, reconnectMax_)));
+}
+
+void ModbusTransport::reconnectNow(){
+  if (!wanted_) return;
+  reconnectTimer_->stop();
+  attempts_ = 0;
+  reconnect();
+}
+
+/**
+ * @details The client starts the response timer of a request with the timeout set at the time
+ * the request is sent, so setting it right before sending gives every request its own timeout.
+ */
+QModbusReply* ModbusTransport::sendRawRequest(const QModbusRequest &request, int serverAddress, int timeout){
+  if (settings_.type == Type::Replay) return replayRequest(request, serverAddress, timeout);
+  if (!client_) return nullptr;
+  client_->setTimeout(timeout > 0 ? timeout : settings_.timeout);
+  return client_->sendRawRequest(request, serverAddress);
+}
+
+int ModbusTransport::maxInFlight() const {
+  if (settings_.type != Type::Tcp) return 1;
+  return settings_.maxInFlight > 0 ? settings_.maxInFlight : tcpInFlightDefault;
+}
+
+void ModbusTransport::setReconnectInterval(int interval, int maxInterval){reconnectInterval_ = qMax(0, interval); reconnectMax_ = qMax(reconnectInterval_, maxInterval);}
+bool ModbusTransport::isWanted() const {return wanted_;}
+ModbusTransport::Settings ModbusTransport::settings() const {return settings_;}
+QModbusClient* ModbusTransport::client() const {return client_;}
+QModbusDevice::State ModbusTransport::state() const {
+  if (settings_.type == Type::Replay) return replayOpen_ ? QModbusDevice::ConnectedState : QModbusDevice::UnconnectedState;
+  return client_ ? client_->state() : QModbusDevice::UnconnectedState;
+}
+QModbusDevice::Error ModbusTransport::error() const {
+  if (settings_.type == Type::Replay) return replayOpen_ ? QModbusDevice::NoError : QModbusDevice::ConnectionError;
+  return client_ ? client_->error() : QModbusDevice::ConnectionError;
+}
+QString ModbusTransport::errorString() const {
+  if (settings_.type == Type::Replay) return replayError_.isEmpty() ? QString() : tr("Cannot replay %1: %2").arg(settings_.captureFile, replayError_);
+  return client_ ? client_->errorString() : tr("No Modbus client");
+}
+bool ModbusTransport::isConnected() const {return state() == QModbusDevice::ConnectedState;}
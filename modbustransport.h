@@ -0,0 +1,217 @@
+/**
+ * @file modbustransport.h
+ * @brief Declaration of the ModbusTransport class, which hides whether the controllers are reached over RTU or TCP.
+ */
+
+#ifndef MODBUSTRANSPORT_H
+#define MODBUSTRANSPORT_H
+
+#include <QObject>
+#include <QModbusClient>
+#include <QModbusReply>
+#include <QSerialPort>
+#include <QTimer>
+#include <QVector>
+#include "framecapture.h"
+
+/**
+ * @brief The ModbusTransport class owns the Modbus client used to reach the controllers.
+ *
+ * The transport is either a QModbusRtuSerialMaster on a serial port or a QModbusTcpClient
+ * connected to an Ethernet gateway. It keeps the connection open, reconnects after the link
+ * dropped, doubling the time between two attempts up to reconnectMaxDefault, and tells the
+ * request queue how many transactions may be outstanding at once:
+ * one on a serial line, several on TCP where the MBAP transaction ID correlates the replies.
+ *
+ * A third kind replays a file written by FrameCapture instead of talking to a device. Every
+ * request is answered with the recorded reply of the same request to the same device, either
+ * after the recorded round trip or at once, so field issues can be reproduced and the decoding
+ * can be benchmarked offline through exactly the code that runs on a live bus.
+ */
+class ModbusTransport : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * @brief The Type enum class defines the kinds of transport.
+   */
+  enum class Type {
+    Rtu, /**< Modbus RTU over a serial port */
+    Tcp, /**< Modbus TCP to a gateway or device */
+    Replay /**< Replies read from a capture file */
+  };
+
+  /**
+   * @brief The Settings struct holds the connection parameters of a transport.
+   */
+  struct Settings {
+    Type type{Type::Rtu}; /**< Kind of transport */
+    QString portName; /**< Serial port name, RTU only */
+    int baudRate{QSerialPort::Baud9600}; /**< Baud rate, RTU only */
+    int dataBits{QSerialPort::Data8}; /**< Data bits, RTU only */
+    int parity{QSerialPort::NoParity}; /**< Parity, RTU only */
+    int stopBits{QSerialPort::TwoStop}; /**< Stop bits, RTU only */
+    QString host; /**< Host name or address, TCP only */
+    int port{502}; /**< TCP port, TCP only */
+    QString captureFile; /**< Capture file, replay only */
+    bool realTime{true}; /**< Flag indicating if replies keep their recorded round trip, replay only */
+    int timeout{700}; /**< Response timeout in milliseconds */
+    int numberOfRetries{0}; /**< Retries done by the client itself */
+    int maxInFlight{0}; /**< Outstanding transactions, 0 selects the default of the type */
+  };
+
+  /**
+   * @brief The limits enumeration defines defaults of the transport.
+   */
+  enum limits {
+    tcpInFlightDefault = 8, /**< Outstanding transactions on a TCP connection */
+    reconnectDefault = 3000, /**< Time in milliseconds before the first reconnect attempt */
+    reconnectMaxDefault = 60000 /**< Longest time in milliseconds between two reconnect attempts */
+  };
+
+  /**
+   * @brief Builds settings from an endpoint string.
+   * @param endpoint Either "tcp://host:port" for Modbus TCP, "replay:file" to replay a capture at its
+   * original timing, "replay:file?fast" to replay it as fast as possible, or the name of a serial port for RTU.
+   * @return The settings with default values for everything the endpoint does not specify.
+   */
+  static Settings parse(const QString &endpoint);
+
+  /**
+   * @brief Constructs a transport without a client.
+   * @param parent The parent object.
+   */
+  explicit ModbusTransport(QObject *parent = nullptr);
+
+  /**
+   * @brief Disconnects the client.
+   */
+  ~ModbusTransport();
+
+  /**
+   * @brief Replaces the connection parameters. A connected client is closed and recreated.
+   * @param settings The new connection parameters.
+   */
+  void setSettings(const Settings &settings);
+
+  /**
+   * @brief Opens the connection.
+   * @return true if the connection is open or being opened, false if it failed at once.
+   * @details The transport keeps reconnecting until disconnectDevice() is called.
+   */
+  bool connectDevice();
+
+  /**
+   * @brief Closes the connection and stops reconnecting.
+   */
+  void disconnectDevice();
+
+  /**
+   * @brief Sends a request.
+   * @param request The request PDU.
+   * @param serverAddress The address of the device.
+   * @param timeout The response timeout of this request in milliseconds, 0 to keep the timeout of the settings.
+   * @return The reply, or nullptr if the request could not be sent. The caller owns the reply.
+   */
+  QModbusReply* sendRawRequest(const QModbusRequest &request, int serverAddress, int timeout = 0);
+
+  /**
+   * @brief Sets the time before the first reconnect attempt and the limit of the backoff.
+   * @param interval The time in milliseconds before the first attempt.
+   * @param maxInterval The longest time in milliseconds between two attempts.
+   */
+  void setReconnectInterval(int interval, int maxInterval = reconnectMaxDefault);
+
+  /**
+   * @brief Tries to reopen a lost connection at once and restarts the backoff, e.g. when the adapter is back.
+   */
+  void reconnectNow();
+
+  /**
+   * @brief Checks whether the connection should be kept open.
+   * @return true from connectDevice() until disconnectDevice().
+   */
+  bool isWanted() const;
+
+  Settings settings() const;
+  QModbusClient* client() const;
+  QModbusDevice::State state() const;
+  QModbusDevice::Error error() const;
+  QString errorString() const;
+  bool isConnected() const;
+
+  /**
+   * @brief Returns the number of transactions that may be outstanding at the same time.
+   * @return 1 for RTU, the configured or default pipelining depth for TCP.
+   */
+  int maxInFlight() const;
+
+signals:
+  /**
+   * @brief Emitted when the connection is established, also after a reconnect.
+   */
+  void connected();
+
+  /**
+   * @brief Emitted when the connection is lost or closed.
+   */
+  void disconnected();
+
+  /**
+   * @brief Emitted before a reconnect attempt.
+   * @param attempt The number of the attempt since the connection was lost.
+   */
+  void reconnecting(int attempt);
+
+  /**
+   * @brief Emitted when the client reports an error.
+   * @param error The error.
+   * @param message The description of the error.
+   */
+  void errorOccurred(QModbusDevice::Error error, const QString &message);
+
+private:
+  QModbusClient *client_{nullptr}; /**< The Modbus client of the current settings */
+  QTimer *reconnectTimer_{nullptr}; /**< Timer of the reconnect attempts */
+  Settings settings_; /**< The connection parameters */
+  bool wanted_{false}; /**< Flag indicating if the connection should be kept open */
+  int attempts_{0}; /**< Reconnect attempts since the connection was lost */
+  int reconnectInterval_{reconnectDefault}; /**< Time before the first reconnect attempt */
+  int reconnectMax_{reconnectMaxDefault}; /**< Longest time between two reconnect attempts */
+  QVector<FrameCapture::Record> replay_; /**< Records of the capture being replayed */
+  int replayNext_{0}; /**< Index of the record after the last one replayed */
+  bool replayOpen_{false}; /**< Flag indicating if the capture is loaded */
+  QString replayError_; /**< Reason why the capture could not be loaded */
+
+  /**
+   * @brief Creates the client of the current settings.
+   */
+  void createClient();
+
+  /**
+   * @brief Tracks the state of the client and schedules reconnects.
+   */
+  void onStateChanged(QModbusDevice::State state);
+
+  /**
+   * @brief Tries to open the connection again.
+   */
+  void reconnect();
+
+  /**
+   * @brief Starts the reconnect timer with the backoff of the attempts so far.
+   */
+  void scheduleReconnect();
+
+  /**
+   * @brief Loads the capture file of the settings.
+   */
+  bool openReplay();
+
+  /**
+   * @brief Answers a request from the capture.
+   */
+  QModbusReply* replayRequest(const QModbusRequest &request, int serverAddress, int timeout);
+};
+
+#endif // MODBUSTRANSPORT_H
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include "pollschedule.h"
+#include "e5ccregisters.h"
+
+PollSchedule::PollSchedule()
+{
+  setRule(E5ccRegisters::PV, 0, 10);
+  setRule(E5ccRegisters::Status, 0, 10);
+  setRule(E5ccRegisters::HeaterCurrent, 0, 9);
+  setRule(E5ccRegisters::MV, 0, 9);
+  setRule(E5ccRegisters::SV, 5000, 5);
+  for (const quint16 address : {E5ccRegisters::Alarm1Type, E5ccRegisters::Alarm1Upper, E5ccRegisters::Alarm1Lower,
+                                E5ccRegisters::Alarm2Type, E5ccRegisters::Alarm2Upper, E5ccRegisters::Alarm2Lower}) {
+    setRule(address, 5000, 5);
+  }
+  setRule(E5ccRegisters::MVupper, 60000, 2);
+  setRule(E5ccRegisters::MVlower, 60000, 2);
+  for (const quint16 address : {E5ccRegisters::PID_P, E5ccRegisters::PID_I, E5ccRegisters::PID_D}) {
+    setRule(address, 60000, 1);
+  }
+}
+
+void PollSchedule::setRule(quint16 address, int period, int priority){
+  removeRule(address);
+  Rule rule;
+  rule.address = address;
+  rule.period = qMax(0, period);
+  rule.priority = priority;
+  rules_.append(rule);
+  std::stable_sort(rules_.begin(), rules_.end(), [](const Rule &a, const Rule &b) {return a.priority > b.priority;});
+}
+
+void PollSchedule::removeRule(quint16 address){
+  for (int i = 0; i < rules_.size(); i++) {
+    if (rules_.at(i).address == address) {
+      rules_.remove(i);
+      return;
+    }
+  }
+}
+
+/**
+ * @details The requested registers come first, then the due registers are added one by one in
+ * the order of their priority. A register is skipped if adding it would need more than
+ * maxBlocks() windows.
+ */
+QVector<ModbusBlock> PollSchedule::plan(int id, qint64 now) const {
+  QVector<quint16> addresses = requested_.value(id);
+  QVector<ModbusBlock> blocks = ModbusBlock::plan(addresses);
+  for (const Rule &rule : rules_) {
+    if (rule.period > 0 && due_.value(key(id, rule.address), 0) > now) continue;
+    addresses.append(rule.address);
+    const QVector<ModbusBlock> tried = ModbusBlock::plan(addresses);
+    if (tried.size() > maxBlocks_) {
+      addresses.removeLast();
+      continue;
+    }
+    blocks = tried;
+  }
+  return blocks;
+}
+
+void PollSchedule::request(int id, quint16 address){
+  QVector<quint16> &requested = requested_[id];
+  if (!requested.contains(address)) requested.append(address);
+}
+
+void PollSchedule::markRead(int id, quint16 start, int count, qint64 now){
+  auto requested = requested_.find(id);
+  if (requested != requested_.end()) {
+    requested->erase(std::remove_if(requested->begin(), requested->end(), [start, count](quint16 address) {
+      return address >= start && address + ModbusBlock::width <= start + count;
+    }), requested->end());
+    if (requested->isEmpty()) requested_.erase(requested);
+  }
+  for (const Rule &rule : qAsConst(rules_)) {
+    if (rule.address >= start && rule.address + ModbusBlock::width <= start + count) {
+      due_.insert(key(id, rule.address), now + rule.period);
+    }
+  }
+}
+
+quint32 PollSchedule::key(int id, quint16 address){
+  return (static_cast<quint32>(id & 0xFFFF) << 16) | address;
+}
+
+void PollSchedule::reset(){due_.clear(); requested_.clear();}
+QVector<PollSchedule::Rule> PollSchedule::rules() const {return rules_;}
+void PollSchedule::setMaxBlocks(int maxBlocks){maxBlocks_ = qMax(1, maxBlocks);}
+int PollSchedule::maxBlocks() const {return maxBlocks_;}
@@ -0,0 +1,108 @@
+/**
+ * @file pollschedule.h
+ * @brief Declaration of the PollSchedule class, the per-register poll table of the status poll.
+ */
+
+#ifndef POLLSCHEDULE_H
+#define POLLSCHEDULE_H
+
+#include <QHash>
+#include <QVector>
+#include <QtGlobal>
+#include "modbusblock.h"
+
+/**
+ * @brief The PollSchedule class decides which registers are read by a status poll of a device.
+ *
+ * Every register has a rule with its own period and priority. A period of 0 means the register is
+ * read with every poll of the device, so it follows the device interval of the BusScheduler, which
+ * may adapt to the process. A register with a longer period is read when its period has elapsed.
+ * The due registers are packed by ModbusBlock::plan() into at most maxBlocks() block reads, filled
+ * in the order of their priority; registers that do not fit stay due for the next poll. A register
+ * that happens to lie inside a block that is read anyway counts as read, so slow parameters next to
+ * fast ones are refreshed for free.
+ */
+class PollSchedule
+{
+public:
+  /**
+   * @brief The Rule struct describes how one register is polled.
+   */
+  struct Rule {
+    quint16 address{}; /**< Register address of the variable */
+    int period{}; /**< Time in milliseconds between two reads, 0 for every poll */
+    int priority{1}; /**< Order in which due registers are packed into the blocks of a poll */
+  };
+
+  /**
+   * @brief The limits enumeration defines the default budget of a poll.
+   */
+  enum limits {
+    maxBlocksDefault = 3 /**< Block reads of one poll */
+  };
+
+  /**
+   * @brief Constructs the default schedule: PV, status word, heater current and MV with every poll,
+   * SV and the alarm settings every 5 s, MV limits and PID every 60 s.
+   * @details Status word and heater current lie between PV and MV and the alarm settings follow SV,
+   * so they are read within blocks that are read anyway and cost no extra round trip.
+   */
+  PollSchedule();
+
+  /**
+   * @brief Adds a rule or replaces the rule of the same register.
+   * @param address The register address of the variable.
+   * @param period The time in milliseconds between two reads, 0 for every poll.
+   * @param priority The packing order, higher first.
+   */
+  void setRule(quint16 address, int period, int priority = 1);
+
+  /**
+   * @brief Stops polling a register.
+   * @param address The register address of the variable.
+   */
+  void removeRule(quint16 address);
+
+  /**
+   * @brief Returns the block reads of the next poll of a device.
+   * @param id The Modbus slave address of the device.
+   * @param now The current time in milliseconds.
+   * @return The windows, sorted by their start address.
+   */
+  QVector<ModbusBlock> plan(int id, qint64 now) const;
+
+  /**
+   * @brief Books the read of a block, so the registers it covers become due one period later.
+   * @param id The Modbus slave address of the device.
+   * @param start The first register address of the block.
+   * @param count The number of registers of the block.
+   * @param now The current time in milliseconds.
+   */
+  void markRead(int id, quint16 start, int count, qint64 now);
+
+  /**
+   * @brief Reads a register with the next poll of a device once, e.g. to verify a write.
+   * @param id The Modbus slave address of the device.
+   * @param address The register address of the variable, with or without a rule.
+   */
+  void request(int id, quint16 address);
+
+  /**
+   * @brief Makes every register of every device due.
+   */
+  void reset();
+
+  QVector<Rule> rules() const;
+  void setMaxBlocks(int maxBlocks);
+  int maxBlocks() const;
+
+private:
+  QVector<Rule> rules_; /**< Rules sorted by descending priority */
+  QHash<quint32, qint64> due_; /**< Time at which a register of a device is due, keyed by key() */
+  QHash<int, QVector<quint16>> requested_; /**< Registers read once with the next poll, per device */
+  int maxBlocks_{maxBlocksDefault}; /**< Block reads of one poll */
+
+  static quint32 key(int id, quint16 address);
+};
+
+#endif // POLLSCHEDULE_H
@@ -0,0 +1,64 @@
+#include <QDir>
+#include <QFileSystemWatcher>
+#include <QSerialPortInfo>
+#include "portwatcher.h"
+
+namespace {
+const char *const devDirectory = "/dev"; /**< Directory of the device nodes */
+}
+
+PortWatcher::PortWatcher(QObject *parent)
+  : QObject(parent)
+{
+  timer_ = new QTimer(this);
+  connect(timer_, &QTimer::timeout, this, &PortWatcher::rescan);
+#ifdef Q_OS_LINUX
+  watcher_ = new QFileSystemWatcher(this);
+  connect(watcher_, &QFileSystemWatcher::directoryChanged, this, &PortWatcher::rescan);
+#endif
+}
+
+void PortWatcher::start(int interval){
+  stop();
+#ifdef Q_OS_LINUX
+  watcher_->addPath(devDirectory);
+#endif
+  ports_ = scan();
+  if (!isEventDriven()) timer_->start(qMax(100, interval));
+}
+
+void PortWatcher::stop(){
+  timer_->stop();
+  if (watcher_ && !watcher_->directories().isEmpty()) watcher_->removePaths(watcher_->directories());
+}
+
+/**
+ * @details The differences are taken before any signal is emitted, so a receiver that restarts
+ * the watcher does not see a change twice.
+ */
+void PortWatcher::rescan(){
+  const QSet<QString> ports = scan();
+  const QSet<QString> removed = QSet<QString>(ports_).subtract(ports);
+  const QSet<QString> added = QSet<QString>(ports).subtract(ports_);
+  ports_ = ports;
+  for (const QString &portName : removed) emit portRemoved(portName);
+  for (const QString &portName : added) emit portAdded(portName);
+}
+
+/**
+ * @details With device events only the tty nodes of USB, ACM, on-board and Bluetooth serial
+ * ports are listed, the names QSerialPortInfo uses on Linux.
+ */
+QSet<QString> PortWatcher::scan() const {
+  QSet<QString> ports;
+  if (isEventDriven()) {
+    const QStringList filters = {"ttyUSB*", "ttyACM*", "ttyS*", "ttyAMA*", "rfcomm*"};
+    for (const QString &name : QDir(devDirectory).entryList(filters, QDir::System | QDir::NoDotAndDotDot)) ports.insert(name);
+    return ports;
+  }
+  for (const QSerialPortInfo &info : QSerialPortInfo::availablePorts()) ports.insert(info.portName());
+  return ports;
+}
+
+bool PortWatcher::isEventDriven() const {return watcher_ && !watcher_->directories().isEmpty();}
+QSet<QString> PortWatcher::ports() const {return ports_;}
@@ -0,0 +1,83 @@
+/**
+ * @file portwatcher.h
+ * @brief Declaration of the PortWatcher class, which reports serial adapters being plugged in and out.
+ */
+
+#ifndef PORTWATCHER_H
+#define PORTWATCHER_H
+
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+class QFileSystemWatcher;
+
+/**
+ * @brief The PortWatcher class reports serial ports that appear or disappear.
+ *
+ * On Linux the device directory /dev is watched with inotify through QFileSystemWatcher. The
+ * kernel creates and removes the node of a USB serial adapter when it is plugged in or out, so
+ * the change is reported within milliseconds and nothing is enumerated while the ports stay as
+ * they are. A change only lists the tty nodes of /dev, which is much cheaper than the udev
+ * queries of QSerialPortInfo::availablePorts(). Where the directory cannot be watched, the ports
+ * are enumerated with QSerialPortInfo on a timer instead.
+ */
+class PortWatcher : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * @brief Constructs an idle watcher.
+   * @param parent The parent object.
+   */
+  explicit PortWatcher(QObject *parent = nullptr);
+
+  /**
+   * @brief Takes the current ports as reference and starts watching.
+   * @param interval The time in milliseconds between two enumerations where no device events are available.
+   */
+  void start(int interval);
+
+  /**
+   * @brief Stops watching.
+   */
+  void stop();
+
+  /**
+   * @brief Checks whether changes are reported by device events instead of a timer.
+   * @return true while /dev is watched.
+   */
+  bool isEventDriven() const;
+
+  QSet<QString> ports() const;
+
+signals:
+  /**
+   * @brief Emitted when a serial port has appeared.
+   * @param portName The name of the port, as QSerialPortInfo::portName() returns it.
+   */
+  void portAdded(const QString &portName);
+
+  /**
+   * @brief Emitted when a serial port has disappeared.
+   * @param portName The name of the port, as QSerialPortInfo::portName() returns it.
+   */
+  void portRemoved(const QString &portName);
+
+private:
+  QFileSystemWatcher *watcher_{nullptr}; /**< Watcher of the device directory, Linux only */
+  QTimer *timer_{nullptr}; /**< Timer of the enumeration without device events */
+  QSet<QString> ports_; /**< Ports present at the last check */
+
+  /**
+   * @brief Compares the present ports with those of the last check and reports the difference.
+   */
+  void rescan();
+
+  /**
+   * @brief Returns the names of the present ports.
+   */
+  QSet<QString> scan() const;
+};
+
+#endif // PORTWATCHER_H
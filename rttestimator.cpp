@@ -0,0 +1,46 @@
+#include "rttestimator.h"
+
+void RttEstimator::record(int id, qint64 rtt){
+  State &state = states_[id];
+  const double sample = static_cast<double>(qMax<qint64>(0, rtt));
+  if (!state.sampled) {
+    state.srtt = sample;
+    state.rttvar = sample / 2.0;
+    state.sampled = true;
+  } else {
+    state.rttvar = 0.75 * state.rttvar + 0.25 * qAbs(state.srtt - sample);
+    state.srtt = 0.875 * state.srtt + 0.125 * sample;
+  }
+  state.backoff = 1;
+}
+
+void RttEstimator::backoff(int id){
+  State &state = states_[id];
+  if (timeout(id) < maxTimeout_) state.backoff *= 2;
+}
+
+/**
+ * @details The deviation term is at least one millisecond, so a perfectly steady line still
+ * leaves room for the jitter of the event loop. The transmission time is added after the bounds
+ * and is not doubled by a backoff, so a long frame does not inflate the timeout of short ones.
+ */
+int RttEstimator::timeout(int id, int wireTime) const {
+  const int wire = qMax(0, wireTime);
+  const auto it = states_.constFind(id);
+  if (it == states_.constEnd()) return qBound(minTimeout_, initial_, maxTimeout_) + wire;
+  const double base = it->sampled ? it->srtt + deviationFactor * qMax(1.0, it->rttvar) : initial_;
+  return qBound(minTimeout_, static_cast<int>(base * it->backoff + 0.5), maxTimeout_) + wire;
+}
+
+void RttEstimator::setBounds(int minTimeout, int maxTimeout){
+  minTimeout_ = qMax(10, qMin(minTimeout, maxTimeout));
+  maxTimeout_ = qMax(minTimeout_, maxTimeout);
+}
+
+void RttEstimator::reset(){states_.clear();}
+void RttEstimator::setInitial(int initial){initial_ = qMax(1, initial);}
+int RttEstimator::initial() const {return initial_;}
+int RttEstimator::minTimeout() const {return minTimeout_;}
+int RttEstimator::maxTimeout() const {return maxTimeout_;}
+double RttEstimator::srtt(int id) const {return states_.value(id).srtt;}
+double RttEstimator::rttvar(int id) const {return states_.value(id).rttvar;}
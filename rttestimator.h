@@ -0,0 +1,99 @@
+/**
+ * @file rttestimator.h
+ * @brief Declaration of the RttEstimator class, which derives Modbus response timeouts from measured round trips.
+ */
+
+#ifndef RTTESTIMATOR_H
+#define RTTESTIMATOR_H
+
+#include <QHash>
+#include <QtGlobal>
+
+/**
+ * @brief The RttEstimator class keeps a running round trip estimate per device and derives the
+ * response timeout from it.
+ *
+ * The estimate follows the retransmission timer of TCP (RFC 6298): the smoothed round trip time
+ * srtt and its mean deviation rttvar are updated with gains of 1/8 and 1/4, and the timeout is
+ * srtt + k * rttvar, bounded by minTimeout() and maxTimeout(). A device without a sample uses the
+ * initial timeout. Each timeout doubles the timeout of the device until the next valid sample, so
+ * a device that has become slow is not hammered with premature retries.
+ *
+ * On a serial line the time a frame spends on the wire grows with its length, so the estimate
+ * is kept without it: the caller records the round trip minus the transmission time of request
+ * and response, and passes the transmission time of the next request to timeout(). A block read
+ * of 50 registers then gets the time it needs at 9600 baud, although the estimate has been
+ * learned from short status polls.
+ */
+class RttEstimator
+{
+public:
+  /**
+   * @brief The limits enumeration defines the default bounds in milliseconds.
+   */
+  enum limits {
+    initialDefault = 700, /**< Timeout of a device without a sample */
+    minTimeoutDefault = 50, /**< Shortest timeout */
+    maxTimeoutDefault = 2000, /**< Longest timeout */
+    deviationFactor = 4 /**< Factor k of the deviation in the timeout */
+  };
+
+  /**
+   * @brief Records a round trip. Round trips of retried requests must not be recorded.
+   * @param id The Modbus slave address of the device.
+   * @param rtt The time in milliseconds between sending the request and receiving the reply,
+   *            less the transmission time of both frames.
+   */
+  void record(int id, qint64 rtt);
+
+  /**
+   * @brief Doubles the timeout of a device after a request timed out.
+   * @param id The Modbus slave address of the device.
+   */
+  void backoff(int id);
+
+  /**
+   * @brief Returns the response timeout of a device.
+   * @param id The Modbus slave address of the device.
+   * @param wireTime The transmission time of the request and its response in milliseconds.
+   * @return The timeout in milliseconds.
+   */
+  int timeout(int id, int wireTime = 0) const;
+
+  /**
+   * @brief Forgets all devices, e.g. after the transport has changed.
+   */
+  void reset();
+
+  /**
+   * @brief Sets the bounds of the timeout.
+   * @param minTimeout The shortest timeout in milliseconds.
+   * @param maxTimeout The longest timeout in milliseconds.
+   */
+  void setBounds(int minTimeout, int maxTimeout);
+
+  void setInitial(int initial);
+  int initial() const;
+  int minTimeout() const;
+  int maxTimeout() const;
+  double srtt(int id) const;
+  double rttvar(int id) const;
+
+private:
+  /**
+   * @brief The State struct holds the estimate of one device.
+   */
+  struct State {
+    double srtt{}; /**< Smoothed round trip time in ms */
+    double rttvar{}; /**< Mean deviation of the round trip time in ms */
+    int backoff{1}; /**< Factor of the timeout after timeouts */
+    bool sampled{false}; /**< Flag indicating if a round trip has been recorded */
+  };
+
+  QHash<int, State> states_; /**< Estimates per device */
+  int initial_{initialDefault}; /**< Timeout of a device without a sample */
+  int minTimeout_{minTimeoutDefault}; /**< Shortest timeout */
+  int maxTimeout_{maxTimeoutDefault}; /**< Longest timeout */
+};
+
+#endif // RTTESTIMATOR_H
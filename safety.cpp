@@ -1,4 +1,5 @@
 #include "safety.h"
+#include "e5ccregisters.h"
 
 /**
  * @copybrief Safety::Safety(DataSummary*)
@@ -187,6 +188,56 @@ bool Safety::isMVupper(){
 
 
 
+/**
+ * @details The danger types 4 and 5 stand for a heater burnout and an input error detected by the
+ * controller itself, which is faster than waiting for the temperature change check.
+ */
+void Safety::setDeviceStatus(quint32 status){
+  QMutexLocker locker(&mutex_);
+  const quint32 changed = status ^ deviceStatus_;
+  deviceStatus_ = status;
+  const quint32 alarms[] = {E5ccRegisters::alarm1, E5ccRegisters::alarm2};
+  for (int i = 0; i < 2; i++) {
+    if (!(changed & alarms[i])) continue;
+    if (status & alarms[i]) emit logMsgWithColor("Alarm " + QString::number(i + 1) + " of the controller is on", QColor(255, 0, 0, 255));
+    else emit logMsgWithColor("Alarm " + QString::number(i + 1) + " of the controller is off", QColor(0, 0, 255, 255));
+  }
+  if (!timerMVCheck_->isActive()) return;
+  const quint32 raised = changed & status;
+  if (raised & E5ccRegisters::heaterBurnout) {
+    emit dangerSignal(4);
+  } else if (raised & E5ccRegisters::inputError) {
+    emit dangerSignal(5);
+  }
+}
+
+/**
+ * @details The nominal current is smoothed exponentially, so a slowly ageing heater or a changing
+ * mains voltage does not count as a failure. A sample below heaterArmCurrent does not teach the
+ * nominal current, which keeps a missing current transformer from arming the check.
+ */
+void Safety::checkHeaterCurrent(double MV, double current){
+  const double heaterArmCurrent = 0.5;
+  QMutexLocker locker(&mutex_);
+  if (MV < heaterMinMV_) {
+    heaterFailCount_ = 0;
+    return;
+  }
+  if (current >= heaterArmCurrent && current >= heaterCurrentRatio_ * heaterNominal_) {
+    heaterNominal_ = (heaterNominal_ > 0.0) ? 0.9 * heaterNominal_ + 0.1 * current : current;
+    heaterFailCount_ = 0;
+    return;
+  }
+  if (heaterNominal_ <= 0.0 || !timerMVCheck_->isActive()) return;
+  heaterFailCount_++;
+  emit logMsgWithColor("Detective : Heater current " + QString::number(current) + " A at MV " + QString::number(MV)
+                       + " %, nominal " + QString::number(heaterNominal_, 'f', 1) + " A", QColor(255, 0, 0, 255));
+  if (heaterFailCount_ >= heaterFailPolls_) {
+    heaterFailCount_ = 0;
+    emit dangerSignal(6);
+  }
+}
+
 void Safety::addTemperature(double temp){
   vTempHistory_.push_back(temp);
   if (vTempHistory_.size() > 100) vTempHistory_.remove(0);
@@ -216,6 +267,7 @@ bool Safety::isTimerTempChangeCheckRunning() const {return timerTempChange_->isA
 
 double Safety::diffTemp(double temp1, double temp2) const {return temp1 - temp2;}
 double Safety::getTemperature() const {return temperature_;}
+double Safety::getHeaterNominal() const {return heaterNominal_;}
 double Safety::getPermitedMaxTemp() const {return permitedMaxTemp_;}
 double Safety::getMVUpper() const {return MVUpper_;}
 double Safety::getMV() const {return MV_;}
@@ -255,6 +307,9 @@ void Safety::setIgnoreTempRange(double temp, double lower, double upper){
   ignoreTempRange_ = qMakePair(temp + lower, temp + upper);
 }
 void Safety::setDropThreshold(int dropThreshold) {dropThreshold_ = dropThreshold;}
+void Safety::setHeaterMinMV(double MV) {QMutexLocker locker(&mutex_); heaterMinMV_ = MV;}
+void Safety::setHeaterCurrentRatio(double ratio) {QMutexLocker locker(&mutex_); heaterCurrentRatio_ = qBound(0.0, ratio, 1.0);}
+void Safety::setHeaterFailPolls(int polls) {QMutexLocker locker(&mutex_); heaterFailPolls_ = qMax(1, polls);}
 
 void Safety::setIsSTC(bool isSTC){
   isSTC_ = isSTC;
@@ -196,6 +196,50 @@ public:
 
   void setDropThreshold(int dropThreshold);
 
+  /**
+  @brief Takes the status word polled from the controller.
+  @param status Status double word, see E5ccRegisters::statusBit.
+  @details A heater burnout or an input error reported by the controller while the monitoring runs
+  emits dangerSignal() at once. Alarm outputs are logged.
+  */
+  void setDeviceStatus(quint32 status);
+
+  /**
+  @brief Correlates the output power with the heater current of one poll.
+  @param MV Output power in percent.
+  @param current Heater current in A.
+  @details The current the heater draws while the output is on is learned as nominal current. Once
+  it is known, an output of at least the heater MV threshold with a current below the set fraction
+  of the nominal current points to a burnt heater or an open SSR; after the set number of such
+  polls in a row dangerSignal(6) is emitted. Without a current transformer the current stays 0,
+  no nominal current is learned and the check never triggers.
+  */
+  void checkHeaterCurrent(double MV, double current);
+
+  /**
+  @brief Sets the output power from which the heater current is checked.
+  @param MV Output power in percent. A shorter on-time cannot be measured by the controller.
+  */
+  void setHeaterMinMV(double MV);
+
+  /**
+  @brief Sets the fraction of the nominal current below which the heater counts as failed.
+  @param ratio Fraction between 0 and 1.
+  */
+  void setHeaterCurrentRatio(double ratio);
+
+  /**
+  @brief Sets the number of polls in a row with too little current before a danger is signalled.
+  @param polls Number of polls.
+  */
+  void setHeaterFailPolls(int polls);
+
+  /**
+  @brief Getter function for the learned nominal heater current.
+  @return The nominal heater current in A, 0 while it is unknown.
+  */
+  double getHeaterNominal() const;
+
   /**
   @brief Checks whether the temperature has changed above the threshold value.
   */
@@ -371,6 +415,12 @@ private:
     bool idDrop_{false}; /**< Whether the temperature is droped */
     int dropCount_{0}; /** Counter for temperature drop */
     int dropThreshold_{10}; /**< The temperature drop threshold. */
+    quint32 deviceStatus_{0}; /**< The last status word polled from the controller. */
+    double heaterMinMV_{20.0}; /**< The output power from which the heater current is checked, in percent. */
+    double heaterCurrentRatio_{0.3}; /**< The fraction of the nominal current below which the heater counts as failed. */
+    int heaterFailPolls_{3}; /**< The number of polls in a row with too little current before a danger. */
+    int heaterFailCount_{0}; /**< The current number of polls in a row with too little current. */
+    double heaterNominal_{0.0}; /**< The learned nominal heater current in A, 0 while unknown. */
     /**
     @brief Check if the current temperature is different from the previous temperature
     @return true if the temperature has changed, false otherwise
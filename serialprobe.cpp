@@ -0,0 +1,138 @@
+#include <QSettings>
+#include "serialprobe.h"
+#include "e5ccregisters.h"
+
+SerialProbe::SerialProbe(QObject *parent)
+  : QObject(parent)
+{
+}
+
+/**
+ * @details The E5CC communicates at 9600 to 57600 baud with 8 data bits for Modbus, even, odd
+ * or no parity and one or two stop bits. Even parity with one stop bit is tried first at each
+ * rate, since it is the factory setting of the frame.
+ */
+QVector<ModbusTransport::Settings> SerialProbe::candidates(const ModbusTransport::Settings &preferred){
+  QVector<ModbusTransport::Settings> candidates;
+  candidates.append(preferred);
+  const int baudRates[] = {QSerialPort::Baud57600, QSerialPort::Baud38400, QSerialPort::Baud19200, QSerialPort::Baud9600};
+  const int frames[][2] = {{QSerialPort::EvenParity, QSerialPort::OneStop}, {QSerialPort::NoParity, QSerialPort::TwoStop},
+                           {QSerialPort::OddParity, QSerialPort::OneStop}, {QSerialPort::NoParity, QSerialPort::OneStop}};
+  for (const int baudRate : baudRates) {
+    for (const auto &frame : frames) {
+      if (baudRate == preferred.baudRate && preferred.dataBits == QSerialPort::Data8
+          && frame[0] == preferred.parity && frame[1] == preferred.stopBits) continue;
+      ModbusTransport::Settings settings = preferred;
+      settings.baudRate = baudRate;
+      settings.dataBits = QSerialPort::Data8;
+      settings.parity = frame[0];
+      settings.stopBits = frame[1];
+      candidates.append(settings);
+    }
+  }
+  return candidates;
+}
+
+bool SerialProbe::load(const QString &portName, int slaveId, ModbusTransport::Settings &settings){
+  QSettings stored;
+  stored.beginGroup(group(portName, slaveId));
+  if (!stored.contains("baudRate")) return false;
+  settings.baudRate = stored.value("baudRate").toInt();
+  settings.dataBits = stored.value("dataBits", QSerialPort::Data8).toInt();
+  settings.parity = stored.value("parity", QSerialPort::NoParity).toInt();
+  settings.stopBits = stored.value("stopBits", QSerialPort::TwoStop).toInt();
+  return true;
+}
+
+void SerialProbe::save(const QString &portName, int slaveId, const ModbusTransport::Settings &settings){
+  QSettings stored;
+  stored.beginGroup(group(portName, slaveId));
+  stored.setValue("baudRate", settings.baudRate);
+  stored.setValue("dataBits", settings.dataBits);
+  stored.setValue("parity", settings.parity);
+  stored.setValue("stopBits", settings.stopBits);
+}
+
+QString SerialProbe::describe(const ModbusTransport::Settings &settings){
+  QChar parity('N');
+  if (settings.parity == QSerialPort::EvenParity) parity = 'E';
+  else if (settings.parity == QSerialPort::OddParity) parity = 'O';
+  return QString("%1 %2%3%4").arg(settings.baudRate).arg(settings.dataBits).arg(parity).arg(settings.stopBits);
+}
+
+void SerialProbe::start(const QVector<ModbusTransport::Settings> &candidates, int slaveId){
+  stop();
+  candidates_ = candidates;
+  next_ = 0;
+  slaveId_ = slaveId;
+  tryNext();
+}
+
+/**
+ * @details A candidate whose port cannot be opened ends the probe, since no other candidate
+ * would open it either.
+ */
+void SerialProbe::tryNext(){
+  close();
+  if (next_ >= candidates_.size()) {
+    candidates_.clear();
+    emit failed();
+    return;
+  }
+  ModbusTransport::Settings settings = candidates_.at(next_);
+  settings.timeout = probeTimeout_;
+  settings.numberOfRetries = 0;
+  transport_ = new ModbusTransport(this);
+  transport_->setSettings(settings);
+  if (!transport_->connectDevice()) {
+    close();
+    candidates_.clear();
+    emit failed();
+    return;
+  }
+  queue_ = new ModbusQueue(this);
+  queue_->setAdaptiveTimeout(false);
+  queue_->setMaxRetries(0);
+  queue_->setTransport(transport_);
+  const int index = next_;
+  queue_->enqueue(E5ccRegisters::readRequest(E5ccRegisters::PV, E5ccRegisters::at(E5ccRegisters::PV).width), slaveId_,
+                  [this, index](const ModbusResult &result) {
+    if (index != next_ || candidates_.isEmpty()) return;
+    if (result.isValid() || result.response.isException()) {
+      const ModbusTransport::Settings settings = candidates_.at(index);
+      candidates_.clear();
+      close();
+      emit found(settings);
+      return;
+    }
+    next_++;
+    QMetaObject::invokeMethod(this, [this]() {if (!candidates_.isEmpty()) tryNext();}, Qt::QueuedConnection);
+  });
+}
+
+void SerialProbe::close(){
+  if (queue_) {
+    queue_->clear();
+    queue_->deleteLater();
+    queue_ = nullptr;
+  }
+  if (transport_) {
+    transport_->disconnectDevice();
+    transport_->deleteLater();
+    transport_ = nullptr;
+  }
+}
+
+void SerialProbe::stop(){
+  candidates_.clear();
+  close();
+}
+
+QString SerialProbe::group(const QString &portName, int slaveId){
+  QString port = portName;
+  port.replace('/', '_');
+  return QString("serial/%1_%2").arg(port).arg(slaveId);
+}
+
+void SerialProbe::setProbeTimeout(int timeout){probeTimeout_ = qMax(10, timeout);}
+bool SerialProbe::isRunning() const {return !candidates_.isEmpty();}
@@ -0,0 +1,123 @@
+/**
+ * @file serialprobe.h
+ * @brief Declaration of the SerialProbe class, which detects the serial settings a controller answers at.
+ */
+
+#ifndef SERIALPROBE_H
+#define SERIALPROBE_H
+
+#include <QObject>
+#include <QVector>
+#include "modbusqueue.h"
+#include "modbustransport.h"
+
+/**
+ * @brief The SerialProbe class finds the fastest serial settings at which a controller responds.
+ *
+ * The candidates are tried one after the other on the port, each with a single read of PV and a
+ * short timeout, and the probe locks onto the first one that gets an answer. candidates() puts the
+ * settings of the last connection first and orders the others from the fastest baud rate down, so
+ * a known controller is found with one probe and an unknown one runs at the highest rate it is
+ * configured for. The settings found are stored per port and slave address with save().
+ */
+class SerialProbe : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * @brief The limits enumeration defines the defaults of a probe.
+   */
+  enum limits {
+    probeTimeoutDefault = 150 /**< Response timeout of one candidate in milliseconds */
+  };
+
+  /**
+   * @brief Constructs an idle probe.
+   * @param parent The parent object.
+   */
+  explicit SerialProbe(QObject *parent = nullptr);
+
+  /**
+   * @brief Returns the settings to try for a port, best first.
+   * @param preferred The settings tried first, e.g. those stored for the device.
+   * @return The preferred settings followed by the baud rates, parities and stop bits the E5CC
+   * supports, fastest first.
+   */
+  static QVector<ModbusTransport::Settings> candidates(const ModbusTransport::Settings &preferred);
+
+  /**
+   * @brief Loads the serial settings stored for a device.
+   * @param portName The serial port.
+   * @param slaveId The Modbus slave address.
+   * @param settings Receives baud rate, data bits, parity and stop bits.
+   * @return false if nothing is stored for the device.
+   */
+  static bool load(const QString &portName, int slaveId, ModbusTransport::Settings &settings);
+
+  /**
+   * @brief Stores the serial settings of a device.
+   * @param portName The serial port.
+   * @param slaveId The Modbus slave address.
+   * @param settings The settings, only the serial parameters are stored.
+   */
+  static void save(const QString &portName, int slaveId, const ModbusTransport::Settings &settings);
+
+  /**
+   * @brief Describes serial settings in the usual short form.
+   * @param settings The settings.
+   * @return E.g. "38400 8E1".
+   */
+  static QString describe(const ModbusTransport::Settings &settings);
+
+  /**
+   * @brief Tries the candidates in order. A running probe is stopped first.
+   * @param candidates The settings to try.
+   * @param slaveId The Modbus slave address of the controller.
+   */
+  void start(const QVector<ModbusTransport::Settings> &candidates, int slaveId);
+
+  /**
+   * @brief Stops a running probe and closes the port.
+   */
+  void stop();
+
+  void setProbeTimeout(int timeout);
+  bool isRunning() const;
+
+signals:
+  /**
+   * @brief Emitted when a candidate got an answer. The port has been closed already.
+   * @param settings The candidate.
+   */
+  void found(const ModbusTransport::Settings &settings);
+
+  /**
+   * @brief Emitted when no candidate got an answer.
+   */
+  void failed();
+
+private:
+  QVector<ModbusTransport::Settings> candidates_; /**< Settings to try */
+  int next_{0}; /**< Index of the candidate being tried */
+  int slaveId_{1}; /**< Modbus slave address of the controller */
+  int probeTimeout_{probeTimeoutDefault}; /**< Response timeout of one candidate */
+  ModbusTransport *transport_{nullptr}; /**< Transport of the candidate being tried */
+  ModbusQueue *queue_{nullptr}; /**< Queue of the candidate being tried */
+
+  /**
+   * @brief Opens the port with the next candidate and sends the probe.
+   */
+  void tryNext();
+
+  /**
+   * @brief Closes the port of the candidate being tried.
+   */
+  void close();
+
+  /**
+   * @brief Returns the QSettings group of a device.
+   */
+  static QString group(const QString &portName, int slaveId);
+};
+
+#endif // SERIALPROBE_H
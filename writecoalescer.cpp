@@ -0,0 +1,167 @@
+#include "writecoalescer.h"
+#include "e5ccregisters.h"
+
+WriteCoalescer::WriteCoalescer(ModbusQueue *queue, QObject *parent)
+  : QObject(parent),
+    queue_(queue)
+{
+  connect(queue_, &ModbusQueue::idle, this, [this]() {
+    if (!queueFull_) return;
+    queueFull_ = false;
+    flush();
+  });
+}
+
+void WriteCoalescer::write(int serverAddress, quint16 address, qint32 value){
+  replace(serverAddress, address, value);
+  flush();
+}
+
+void WriteCoalescer::write(const QList<int> &serverAddresses, quint16 address, qint32 value){
+  for (const int serverAddress : serverAddresses) replace(serverAddress, address, value);
+  flush();
+}
+
+void WriteCoalescer::writeBroadcast(const QList<int> &serverAddresses, quint16 address, qint32 value){
+  for (const int serverAddress : serverAddresses) {
+    const quint32 id = key(serverAddress, address);
+    pending_.remove(id);
+    retries_.remove(id);
+    overwritten_.insert(id);
+    if (verified_.remove(id)) emit superseded(serverAddress, address, value);
+  }
+  write(broadcastAddress, address, value);
+}
+
+void WriteCoalescer::writeVerified(int serverAddress, quint16 address, qint32 value){
+  const quint32 id = key(serverAddress, address);
+  pending_.insert(id, value);
+  retries_.remove(id);
+  verified_.insert(id);
+  flush();
+}
+
+/**
+ * @details A plain write over a pending verified write ends the verification, since the
+ * register will no longer hold the verified value.
+ */
+void WriteCoalescer::replace(int serverAddress, quint16 address, qint32 value){
+  const quint32 id = key(serverAddress, address);
+  pending_.insert(id, value);
+  retries_.remove(id);
+  if (verified_.remove(id)) emit superseded(serverAddress, address, value);
+}
+
+/**
+ * @details The pending values are sorted by device and register, so adjacent variables of the
+ * same device follow each other and are packed into one request of up to maxRegisters registers.
+ * A verified write is never packed with others, so the read-back covers exactly its register.
+ */
+void WriteCoalescer::flush(){
+  if (held_ || queueFull_ || inFlight_ > 0 || pending_.isEmpty()) return;
+  overwritten_.clear();
+  const QMap<quint32, qint32> batch = pending_;
+  pending_.clear();
+  QVector<QMap<quint32, qint32>> runs;
+  quint32 previous = 0;
+  for (auto it = batch.cbegin(); it != batch.cend(); ++it) {
+    const bool adjacent = !runs.isEmpty() && it.key() == previous + width
+                          && runs.last().size() * width < maxRegisters
+                          && !verified_.contains(it.key()) && !verified_.contains(previous);
+    if (!adjacent) runs.append(QMap<quint32, qint32>());
+    runs.last().insert(it.key(), it.value());
+    previous = it.key();
+  }
+  inFlight_ = runs.size();
+  for (const QMap<quint32, qint32> &run : qAsConst(runs)) {
+    const quint16 start = static_cast<quint16>(run.firstKey() & 0xFFFF);
+    const int serverAddress = static_cast<int>(run.firstKey() >> 16);
+    const quint16 count = static_cast<quint16>(run.size() * width);
+    const bool readWrite = readWriteMultiple_ && !refusedReadWrite_.contains(serverAddress)
+                           && verified_.contains(run.firstKey());
+    QVector<quint16> values;
+    for (const qint32 value : run) E5ccRegisters::appendRaw(values, value, width);
+    const QModbusRequest request = readWrite ? E5ccRegisters::readWriteRequest(start, values, start, count)
+                                             : E5ccRegisters::writeRequest(start, values);
+    queue_->enqueue(request, serverAddress, [this, run](const ModbusResult &result) {complete(run, result);});
+  }
+}
+
+/**
+ * @details A failed value goes back into the pending writes unless a newer value has been
+ * queued for the same register in the meantime, in which case the newer value wins, or a
+ * broadcast has overwritten it. A connection error does not count as a retry: the queue reports
+ * it at once, so retrying would use up all retries within microseconds. The value is held
+ * instead and sent by resume(). A request the full queue rejected or dropped is reported at once
+ * as well; its value is held until the queue is idle. A device refusing
+ * ReadWriteMultipleRegisters does not count as a retry either.
+ */
+void WriteCoalescer::complete(const QMap<quint32, qint32> &values, const ModbusResult &result){
+  const bool readWrite = result.request.functionCode() == QModbusPdu::ReadWriteMultipleRegisters;
+  const bool refused = readWrite && result.response.isException()
+                       && result.response.exceptionCode() == QModbusPdu::IllegalFunction;
+  if (refused && !refusedReadWrite_.contains(result.serverAddress)) {
+    refusedReadWrite_.insert(result.serverAddress);
+    emit readWriteMultipleRefused(result.serverAddress);
+  }
+  for (auto it = values.cbegin(); it != values.cend(); ++it) {
+    const int serverAddress = static_cast<int>(it.key() >> 16);
+    const quint16 address = static_cast<quint16>(it.key() & 0xFFFF);
+    if (result.isValid()) {
+      retries_.remove(it.key());
+      emit written(serverAddress, address, it.value());
+      if (!verified_.contains(it.key()) || pending_.contains(it.key())) continue;
+      verified_.remove(it.key());
+      if (readWrite) emit readBack(serverAddress, result.startAddress(), result.values());
+      else read(serverAddress, address, width);
+    } else if (refused) {
+      if (!pending_.contains(it.key()) && !overwritten_.contains(it.key())) pending_.insert(it.key(), it.value());
+    } else if (pending_.contains(it.key()) || overwritten_.contains(it.key())) {
+      continue;
+    } else if (result.error == QModbusDevice::ConnectionError) {
+      held_ = true;
+      pending_.insert(it.key(), it.value());
+    } else if (result.error == QModbusDevice::ReplyAbortedError) {
+      queueFull_ = true;
+      pending_.insert(it.key(), it.value());
+    } else if (retries_.value(it.key()) < maxRetries_) {
+      retries_[it.key()]++;
+      pending_.insert(it.key(), it.value());
+    } else {
+      retries_.remove(it.key());
+      if (!pending_.contains(it.key())) verified_.remove(it.key());
+      emit failed(serverAddress, address, it.value(), result.errorString);
+    }
+  }
+  if (--inFlight_ == 0) flush();
+}
+
+/**
+ * @details The read goes to the high lane right after the write has been accepted, ahead of the
+ * next batch of this coalescer.
+ */
+void WriteCoalescer::read(int serverAddress, quint16 start, quint16 count){
+  queue_->enqueue(E5ccRegisters::readRequest(start, count), serverAddress, [this, serverAddress, start](const ModbusResult &result) {
+    if (result.isValid()) emit readBack(serverAddress, start, result.values());
+    else emit failed(serverAddress, start, 0, result.errorString);
+  });
+}
+
+quint32 WriteCoalescer::key(int serverAddress, quint16 address){
+  return (static_cast<quint32>(serverAddress & 0xFFFF) << 16) | address;
+}
+
+void WriteCoalescer::resume(){
+  held_ = false;
+  flush();
+}
+
+void WriteCoalescer::setReadWriteMultiple(bool enable){
+  readWriteMultiple_ = enable;
+  refusedReadWrite_.clear();
+}
+
+void WriteCoalescer::setMaxRetries(int retries){maxRetries_ = qMax(0, retries);}
+bool WriteCoalescer::isReadWriteMultiple() const {return readWriteMultiple_;}
+int WriteCoalescer::pendingCount() const {return pending_.size();}
+bool WriteCoalescer::isIdle() const {return inFlight_ == 0 && pending_.isEmpty();}
@@ -0,0 +1,203 @@
+/**
+ * @file writecoalescer.h
+ * @brief Declaration of the WriteCoalescer class, which collapses rapid register writes to their latest value.
+ */
+
+#ifndef WRITECOALESCER_H
+#define WRITECOALESCER_H
+
+#include <QObject>
+#include <QMap>
+#include <QSet>
+#include "modbusqueue.h"
+
+/**
+ * @brief The WriteCoalescer class sends double word register writes with latest-value-wins semantics.
+ *
+ * A write replaces any pending value of the same register on the same device. Pending writes are
+ * handed to the ModbusQueue as soon as the previous batch of this coalescer has completed, so at
+ * most one batch is on the bus and intermediate values of a dragged spin box never reach it. Writes
+ * to adjacent registers of the same device are merged into one WriteMultipleRegisters request.
+ * A failed write is retried unless a newer value has arrived meanwhile, so the final value is
+ * never lost silently. A write that failed because the bus is not connected is not retried at
+ * once; the coalescer holds all pending values until resume() is called once the transport is
+ * connected again, and only the latest value of each register is sent then. A write the full
+ * queue rejected is held in the same way until the queue has run empty.
+ *
+ * A write that must be confirmed by the device is handed over with writeVerified(). It takes part
+ * in the latest-value-wins order like any other write, but is sent in a request of its own as
+ * ReadWriteMultipleRegisters, so the reply carries the register after the write. A device that
+ * refuses the function code turns the option off for that device, and its verified writes are then
+ * sent as WriteMultipleRegisters followed by a read of the register. A plain write to a register
+ * with a verified write pending replaces the value and ends the verification with superseded().
+ */
+class WriteCoalescer : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * @brief The limits enumeration defines the limits of a batch.
+   */
+  enum limits {
+    width = 2, /**< Number of registers of one variable */
+    broadcastAddress = 0, /**< Server address every device listens to */
+    maxRegisters = 120, /**< Registers of one WriteMultipleRegisters request, at most 123 */
+    maxRetriesDefault = 3 /**< Retries of a failed write */
+  };
+
+  /**
+   * @brief Constructs a coalescer sending through a queue.
+   * @param queue The queue the writes are sent with. The coalescer does not take ownership.
+   * @param parent The parent object.
+   */
+  explicit WriteCoalescer(ModbusQueue *queue, QObject *parent = nullptr);
+
+  /**
+   * @brief Writes a double word, replacing a pending value of the same register.
+   * @param serverAddress The address of the device.
+   * @param address The register address of the variable.
+   * @param value The raw value of the variable.
+   */
+  void write(int serverAddress, quint16 address, qint32 value);
+
+  /**
+   * @brief Writes the same double word to several devices in one batch.
+   * @param serverAddresses The addresses of the devices.
+   * @param address The register address of the variable.
+   * @param value The raw value of the variable.
+   * @details The requests of the batch are queued back to back, so a pipelined transport
+   * sends them without waiting for the replies in between.
+   */
+  void write(const QList<int> &serverAddresses, quint16 address, qint32 value);
+
+  /**
+   * @brief Writes a double word to a group of devices with one broadcast request.
+   * @param serverAddresses The addresses of the devices the broadcast reaches.
+   * @param address The register address of the variable.
+   * @param value The raw value of the variable.
+   * @details The broadcast overwrites the register on every device of the group, so their pending
+   * values are dropped and a value on the bus is not retried if it fails. The broadcast waits for
+   * the batch on the bus like any other write, so no older value reaches a device after it.
+   */
+  void writeBroadcast(const QList<int> &serverAddresses, quint16 address, qint32 value);
+
+  /**
+   * @brief Writes a double word and reads it back, replacing a pending value of the same register.
+   * @param serverAddress The address of the device.
+   * @param address The register address of the variable.
+   * @param value The raw value of the variable.
+   * @details The registers read back are reported with readBack(), a write that fails for good
+   * with failed().
+   */
+  void writeVerified(int serverAddress, quint16 address, qint32 value);
+
+  /**
+   * @brief Enables or disables ReadWriteMultipleRegisters for verified writes.
+   * @param enable true to write and read back in one transaction (function 0x17), false to
+   * send a write followed by a read. A device that refuses the function code gets the write and
+   * read from then on; calling this forgets the refusals.
+   */
+  void setReadWriteMultiple(bool enable);
+  bool isReadWriteMultiple() const;
+
+  /**
+   * @brief Sets how often a failed write is retried.
+   * @param retries The number of retries.
+   */
+  void setMaxRetries(int retries);
+
+  /**
+   * @brief Sends the writes held back since the bus was lost.
+   * @details Call this when the transport has connected again.
+   */
+  void resume();
+
+  /**
+   * @brief Returns the number of writes waiting to be sent.
+   * @return The number of variables.
+   */
+  int pendingCount() const;
+
+  /**
+   * @brief Checks whether no write is waiting or on the bus.
+   * @return true if all writes have completed.
+   */
+  bool isIdle() const;
+
+signals:
+  /**
+   * @brief Emitted when a value has been written to the device.
+   * @param serverAddress The address of the device.
+   * @param address The register address of the variable.
+   * @param value The raw value of the variable.
+   */
+  void written(int serverAddress, quint16 address, qint32 value);
+
+  /**
+   * @brief Emitted when a value could not be written after all retries.
+   * @param serverAddress The address of the device.
+   * @param address The register address of the variable.
+   * @param value The raw value of the variable.
+   * @param message The description of the error.
+   */
+  void failed(int serverAddress, quint16 address, qint32 value, const QString &message);
+
+  /**
+   * @brief Emitted when the registers of a verified write have been read back.
+   * @param serverAddress The address of the device.
+   * @param start The first register address read.
+   * @param values The register values read.
+   */
+  void readBack(int serverAddress, quint16 start, const QVector<quint16> &values);
+
+  /**
+   * @brief Emitted when a device refused ReadWriteMultipleRegisters and the option was turned off for it.
+   * @param serverAddress The address of the device.
+   */
+  void readWriteMultipleRefused(int serverAddress);
+
+  /**
+   * @brief Emitted when a plain write replaced a verified write that had not been read back.
+   * @param serverAddress The address of the device.
+   * @param address The register address of the variable.
+   * @param value The raw value that replaced the verified one.
+   */
+  void superseded(int serverAddress, quint16 address, qint32 value);
+
+private:
+  ModbusQueue *queue_{nullptr}; /**< The queue the writes are sent with */
+  QMap<quint32, qint32> pending_; /**< Latest value per device and register, keyed by key() */
+  QMap<quint32, int> retries_; /**< Retries done per device and register */
+  int maxRetries_{maxRetriesDefault}; /**< Retries of a failed write */
+  int inFlight_{0}; /**< Requests of the current batch that have not completed */
+  bool held_{false}; /**< Writes are held back until resume() because the bus is not connected */
+  bool queueFull_{false}; /**< Writes are held back until the queue is idle because it rejected one */
+  QSet<quint32> verified_; /**< Writes that are read back, keyed by key() */
+  QSet<quint32> overwritten_; /**< Writes on the bus a broadcast has overwritten, keyed by key() */
+  bool readWriteMultiple_{true}; /**< Flag indicating if verified writes use ReadWriteMultipleRegisters */
+  QSet<int> refusedReadWrite_; /**< Devices that refused ReadWriteMultipleRegisters */
+
+  /**
+   * @brief Replaces the pending value of a register with a plain write.
+   */
+  void replace(int serverAddress, quint16 address, qint32 value);
+
+  /**
+   * @brief Sends all pending writes if no batch is on the bus.
+   */
+  void flush();
+
+  /**
+   * @brief Handles the result of one request of a batch.
+   */
+  void complete(const QMap<quint32, qint32> &values, const ModbusResult &result);
+
+  /**
+   * @brief Queues the read of the registers of a verified write.
+   */
+  void read(int serverAddress, quint16 start, quint16 count);
+
+  static quint32 key(int serverAddress, quint16 address);
+};
+
+#endif // WRITECOALESCER_H